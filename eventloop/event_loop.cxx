@@ -1,6 +1,7 @@
 #include "event_loop.h"
 #include "channel.h"
 #include "import_log.h"
+#include "memory_pool.h"
 #include "poller.h"
 #include "timer.h"
 #include "timer_queue.h"
@@ -14,6 +15,8 @@ namespace event_loop {
 
 thread_local EventLoop *t_loop_in_this_thread = nullptr;
 
+const size_t EventLoop::kReadScratchSize;
+
 int CreateEventfd() {
     int evtfd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
     if (evtfd < 0) {
@@ -30,9 +33,14 @@ EventLoop::EventLoop()
       quit_(false),
       calling_pending_functors_(false),
       poller_(new EpollPoller(this)),
+      coarse_clock_(false),
+      log_with_loop_clock_(false),
+      log_micro_timestamp_(0),
       wakeup_fd_(CreateEventfd()),
       wakeup_channel_(new Channel(this, wakeup_fd_)),
-      timer_queue_(new TimerQueue(this)) {
+      timer_queue_(new TimerQueue(this)),
+      memory_pool_(std::make_shared<MemoryPool>()),
+      read_scratch_(new char[kReadScratchSize]) {
     LOG_DEBUG << "EventLoop created " << this << " in thread " << thread_id_;
     if (t_loop_in_this_thread) {
         LOG_FATAL << "Another EventLoop " << t_loop_in_this_thread
@@ -59,11 +67,18 @@ void EventLoop::Loop() {
     AssertInLoopThread();
     looping_ = true;
     quit_ = false; // FIXME: what if someone calls quit() before loop() ?
+    UpdateLoopClock();
+#ifdef EVENTLOOP_USE_MUDUO_LOGGER
+    if (log_with_loop_clock_) {
+        log::Logger::SetThreadCachedClock(&log_micro_timestamp_);
+    }
+#endif
     LOG_TRACE << "EventLoop " << this << " start looping";
 
     while (!quit_) {
         active_channels_.clear();
-        poll_timestamp_ = poller_->Poll(10000, &active_channels_);
+        poller_->Poll(10000, &active_channels_);
+        UpdateLoopClock();
 
         event_handling_ = true;
         // empty channels if timeout
@@ -78,6 +93,11 @@ void EventLoop::Loop() {
     }
 
     LOG_TRACE << "EventLoop " << this << " stop looping";
+#ifdef EVENTLOOP_USE_MUDUO_LOGGER
+    if (log_with_loop_clock_) {
+        log::Logger::SetThreadCachedClock(nullptr);
+    }
+#endif
     looping_ = false;
 }
 
@@ -107,30 +127,60 @@ void EventLoop::QueueInLoop(Functor cb) {
     }
 }
 
-TimerId EventLoop::RunAt(Timestamp time, TimerCallback cb) {
-    return timer_queue_->AddTimer(std::move(cb), time, 0.0);
+TimerId EventLoop::RunAt(Timestamp time, TimerCallback cb, double slack) {
+    return timer_queue_->AddTimer(std::move(cb),
+                                  MonoTimestamp::FromTimestamp(time), 0,
+                                  SecondsToNanoseconds(slack));
+}
+
+TimerId EventLoop::RunAt(MonoTimestamp time, TimerCallback cb,
+                         std::chrono::nanoseconds slack) {
+    return timer_queue_->AddTimer(std::move(cb), time, 0, slack.count());
+}
+
+TimerId EventLoop::RunAfter(double delay, TimerCallback cb, double slack) {
+    return RunAfter(std::chrono::nanoseconds(SecondsToNanoseconds(delay)),
+                    std::move(cb),
+                    std::chrono::nanoseconds(SecondsToNanoseconds(slack)));
+}
+
+TimerId EventLoop::RunAfter(std::chrono::nanoseconds delay, TimerCallback cb,
+                            std::chrono::nanoseconds slack) {
+    MonoTimestamp time = SchedulingNow() + delay.count();
+    return RunAt(time, std::move(cb), slack);
 }
 
-TimerId EventLoop::RunAfter(double delay, TimerCallback cb) {
-    auto now = Timestamp::Now();
-    Timestamp time = now + delay;
-    return RunAt(time, std::move(cb));
+TimerId EventLoop::RunEvery(double interval, TimerCallback cb, double slack) {
+    return RunEveryAfter(interval, interval, std::move(cb), slack);
 }
 
-TimerId EventLoop::RunEvery(double interval, TimerCallback cb) {
-    return RunEveryAfter(interval, interval, std::move(cb));
+TimerId EventLoop::RunEvery(std::chrono::nanoseconds interval,
+                            TimerCallback cb, std::chrono::nanoseconds slack) {
+    return RunEveryAfter(interval, interval, std::move(cb), slack);
 }
 
 TimerId EventLoop::RunEveryAfter(double interval, double delay,
-                                 TimerCallback cb) {
-    auto now = Timestamp::Now();
-    Timestamp time = now + delay;
-    return RunEveryAt(interval, time, std::move(cb));
+                                 TimerCallback cb, double slack) {
+    return RunEveryAfter(
+        std::chrono::nanoseconds(SecondsToNanoseconds(interval)),
+        std::chrono::nanoseconds(SecondsToNanoseconds(delay)), std::move(cb),
+        std::chrono::nanoseconds(SecondsToNanoseconds(slack)));
+}
+
+TimerId EventLoop::RunEveryAfter(std::chrono::nanoseconds interval,
+                                 std::chrono::nanoseconds delay,
+                                 TimerCallback cb,
+                                 std::chrono::nanoseconds slack) {
+    MonoTimestamp time = SchedulingNow() + delay.count();
+    return timer_queue_->AddTimer(std::move(cb), time, interval.count(),
+                                  slack.count());
 }
 
 TimerId EventLoop::RunEveryAt(double interval, Timestamp time,
-                              TimerCallback cb) {
-    return timer_queue_->AddTimer(std::move(cb), time, interval);
+                              TimerCallback cb, double slack) {
+    return timer_queue_->AddTimer(
+        std::move(cb), MonoTimestamp::FromTimestamp(time),
+        SecondsToNanoseconds(interval), SecondsToNanoseconds(slack));
 }
 
 void EventLoop::Cancel(TimerId timer_id) { timer_queue_->Cancel(timer_id); }
@@ -169,6 +219,27 @@ void EventLoop::WakeUpEventRead(Timestamp) {
     }
 }
 
+void EventLoop::UpdateLoopClock() {
+    struct timespec ts;
+    clock_gettime(coarse_clock_ ? CLOCK_REALTIME_COARSE : CLOCK_REALTIME, &ts);
+    poll_timestamp_ = Timestamp(ts);
+    clock_gettime(coarse_clock_ ? CLOCK_MONOTONIC_COARSE : CLOCK_MONOTONIC,
+                  &ts);
+    poll_mono_timestamp_ = MonoTimestamp(static_cast<int64_t>(ts.tv_sec) *
+                                             kNanoSecondsPerSecond +
+                                         ts.tv_nsec);
+    log_micro_timestamp_ = poll_timestamp_.MicrosecondsSinceEpoch();
+}
+
+MonoTimestamp EventLoop::SchedulingNow() const {
+    // before the first poll the loop clock is not set yet. looping_ is only
+    // read in the loop thread, other threads always take the clock
+    if (IsInLoopThread() && looping_) {
+        return poll_mono_timestamp_;
+    }
+    return MonoTimestamp::Now();
+}
+
 EventLoop *EventLoop::GetEventLoopOfThisThread() {
     return t_loop_in_this_thread;
 }
@@ -2,12 +2,14 @@
 #define __MUDUO_EVENT_LOOP_H_
 
 #include "callback.h"
+#include "mono_timestamp.h"
 #include "noncopyable.h"
 #include "this_thread.h"
 #include "timer_id.h"
 #include "timestamp.h"
 
 #include <atomic>
+#include <chrono>
 #include <functional>
 #include <map>
 #include <memory>
@@ -20,6 +22,7 @@ namespace muduo {
 namespace event_loop {
 
 class Channel;
+class MemoryPool;
 class Poller;
 class TimerQueue;
 
@@ -54,24 +57,43 @@ public:
     void QueueInLoop(Functor cb);
 
     // timers
+    //
+    // Timers are scheduled on CLOCK_MONOTONIC, wall clock jumps don't move
+    // them. Each timer accepts an optional @c slack, the lateness it
+    // tolerates. Timers whose slack windows overlap are fired by a single
+    // wakeup, which suits housekeeping timers that need not be exact.
 
     ///
     /// Runs callback at 'time'.
     /// Safe to call from other threads.
     ///
-    TimerId RunAt(Timestamp time, TimerCallback cb);
+    TimerId RunAt(Timestamp time, TimerCallback cb, double slack = 0.0);
+    TimerId RunAt(MonoTimestamp time, TimerCallback cb,
+                  std::chrono::nanoseconds slack = std::chrono::nanoseconds(0));
     ///
     /// Runs callback after @c delay seconds.
     /// Safe to call from other threads.
     ///
-    TimerId RunAfter(double delay, TimerCallback cb);
+    TimerId RunAfter(double delay, TimerCallback cb, double slack = 0.0);
+    TimerId
+    RunAfter(std::chrono::nanoseconds delay, TimerCallback cb,
+             std::chrono::nanoseconds slack = std::chrono::nanoseconds(0));
     ///
     /// Runs callback every @c interval seconds.
     /// Safe to call from other threads.
     ///
-    TimerId RunEvery(double interval, TimerCallback cb);
-    TimerId RunEveryAfter(double interval, double delay, TimerCallback cb);
-    TimerId RunEveryAt(double interval, Timestamp time, TimerCallback cb);
+    TimerId RunEvery(double interval, TimerCallback cb, double slack = 0.0);
+    TimerId
+    RunEvery(std::chrono::nanoseconds interval, TimerCallback cb,
+             std::chrono::nanoseconds slack = std::chrono::nanoseconds(0));
+    TimerId RunEveryAfter(double interval, double delay, TimerCallback cb,
+                          double slack = 0.0);
+    TimerId
+    RunEveryAfter(std::chrono::nanoseconds interval,
+                  std::chrono::nanoseconds delay, TimerCallback cb,
+                  std::chrono::nanoseconds slack = std::chrono::nanoseconds(0));
+    TimerId RunEveryAt(double interval, Timestamp time, TimerCallback cb,
+                       double slack = 0.0);
     ///
     /// Cancels the timer.
     /// Safe to call from other threads.
@@ -88,6 +110,40 @@ public:
 
     bool event_handling() const { return event_handling_; }
 
+    /// Pool of I/O buffer memory for connections on this loop.
+    /// MemoryPool::stats() reports the allocator statistics of the loop.
+    const std::shared_ptr<MemoryPool> &memory_pool() const {
+        return memory_pool_;
+    }
+
+    /// Scratch area that sockets of this loop read overflow into, see
+    /// Buffer::ReadFd(). Only for use in the loop thread, and only
+    /// within a single event handler.
+    static const size_t kReadScratchSize = 256 * 1024;
+    char *read_scratch() { return read_scratch_.get(); }
+
+    ///
+    /// The loop clock, read once per poll wakeup.
+    ///
+    /// Cheaper than Timestamp::Now() but it lags by however long the
+    /// current iteration has run. Only meaningful in the loop thread.
+    ///
+    Timestamp LoopNow() const { return poll_timestamp_; }
+    MonoTimestamp LoopMonoNow() const { return poll_mono_timestamp_; }
+
+    /// Refreshes the loop clock with CLOCK_REALTIME_COARSE and
+    /// CLOCK_MONOTONIC_COARSE, trading resolution (a jiffy, usually
+    /// 1-4ms) for cheaper reads. Timers in the loop thread are then
+    /// scheduled relative to the coarse clock too.
+    /// Must be called before Loop().
+    void set_coarse_clock(bool on) { coarse_clock_ = on; }
+
+    /// Stamps log lines written in the loop thread with the loop clock,
+    /// instead of reading the system clock for every line.
+    /// Only effective with EVENTLOOP_USE_MUDUO_LOGGER.
+    /// Must be called before Loop().
+    void set_log_with_loop_clock(bool on) { log_with_loop_clock_ = on; }
+
     bool IsInLoopThread() const { return thread_id_ == this_thread::tid(); }
     void AssertInLoopThread() {
         if (!IsInLoopThread()) {
@@ -101,6 +157,9 @@ private:
     void AbortNotInLoopThread();
     void CallPendingFunctors();
     void WakeUpEventRead(Timestamp); // waked up
+    void UpdateLoopClock();
+    // base of relative timers, the loop clock if in loop thread
+    MonoTimestamp SchedulingNow() const;
 
 private:
     const pid_t thread_id_;
@@ -118,6 +177,11 @@ private:
     ChannelList active_channels_;
     Channel *current_channel_;
     Timestamp poll_timestamp_;
+    MonoTimestamp poll_mono_timestamp_;
+    bool coarse_clock_;
+    bool log_with_loop_clock_;
+    // poll_timestamp_ in microseconds, for the logger
+    int64_t log_micro_timestamp_;
 
     int wakeup_fd_;
     // unlike in TimerQueue, which is an internal class,
@@ -125,6 +189,9 @@ private:
     std::unique_ptr<Channel> wakeup_channel_;
 
     std::unique_ptr<TimerQueue> timer_queue_;
+
+    std::shared_ptr<MemoryPool> memory_pool_;
+    std::unique_ptr<char[]> read_scratch_;
 };
 
 } // namespace event_loop
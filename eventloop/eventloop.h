@@ -2,7 +2,10 @@
 #define __MUDUO_EVENTLOOP_ALL_H_
 
 #include "event_loop.h"
+#include "memory_pool.h"
+#include "mono_timestamp.h"
 #include "poller.h"
+#include "precision_timer.h"
 #include "timer.h"
 #include "timespan.h"
 #include "timespec.h"
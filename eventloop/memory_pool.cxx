@@ -0,0 +1,158 @@
+#include "memory_pool.h"
+#include "import_log.h"
+
+#include <assert.h>
+#include <cstdlib>
+#include <cstring>
+#include <sys/mman.h>
+
+namespace muduo {
+namespace event_loop {
+
+static_assert((MemoryPool::kMinBlockSize << 9) == MemoryPool::kMaxPooledSize,
+              "one size class per power of two");
+
+constexpr size_t kPageSize = 4096;
+
+MemoryPool::MemoryPool() : huge_pages_(false), max_cached_bytes_(32 << 20) {
+    ::bzero(&stats_, sizeof stats_);
+}
+
+MemoryPool::~MemoryPool() { Trim(); }
+
+size_t MemoryPool::RoundUp(size_t size) {
+    if (size <= kMinBlockSize) {
+        return kMinBlockSize;
+    } else if (size <= kMaxPooledSize) {
+        size_t capacity = kMinBlockSize;
+        while (capacity < size) {
+            capacity <<= 1;
+        }
+        return capacity;
+    } else {
+        return (size + kPageSize - 1) & ~(kPageSize - 1);
+    }
+}
+
+int MemoryPool::ClassIndex(size_t capacity) {
+    int index = 0;
+    while ((kMinBlockSize << index) < capacity) {
+        ++index;
+    }
+    assert((kMinBlockSize << index) == capacity);
+    return index;
+}
+
+char *MemoryPool::Allocate(size_t size, size_t *capacity) {
+    *capacity = RoundUp(size);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    const bool huge = *capacity > kMaxPooledSize && huge_pages_ &&
+                      *capacity >= kHugePageSize;
+    if (huge) {
+        // rounded before the accounting, Deallocate() subtracts this capacity
+        *capacity = (*capacity + kHugePageSize - 1) & ~(kHugePageSize - 1);
+    }
+    ++stats_.allocations;
+    stats_.bytes_in_use += *capacity;
+
+    if (*capacity > kMaxPooledSize) {
+        ++stats_.large_allocations;
+        if (huge) {
+            ++stats_.huge_page_allocations;
+        }
+        lock.unlock();
+        char *block = MapLarge(*capacity);
+        if (!block) {
+            UndoAllocation(*capacity);
+        } else if (huge) {
+            // best effort, only 2MB aligned ranges inside get huge pages
+            ::madvise(block, *capacity, MADV_HUGEPAGE);
+        }
+        return block;
+    }
+
+    std::vector<char *> &free_list = free_lists_[ClassIndex(*capacity)];
+    if (!free_list.empty()) {
+        char *block = free_list.back();
+        free_list.pop_back();
+        ++stats_.pool_hits;
+        stats_.bytes_cached -= *capacity;
+        return block;
+    }
+    lock.unlock();
+    char *block = static_cast<char *>(::malloc(*capacity));
+    if (!block) {
+        UndoAllocation(*capacity);
+    }
+    return block;
+}
+
+void MemoryPool::UndoAllocation(size_t capacity) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    --stats_.allocations;
+    stats_.bytes_in_use -= capacity;
+}
+
+void MemoryPool::Deallocate(char *block, size_t capacity) {
+    if (!block) {
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    ++stats_.deallocations;
+    stats_.bytes_in_use -= capacity;
+
+    if (capacity > kMaxPooledSize) {
+        lock.unlock();
+        ::munmap(block, capacity);
+        return;
+    }
+
+    if (stats_.bytes_cached + capacity <= max_cached_bytes_) {
+        free_lists_[ClassIndex(capacity)].push_back(block);
+        stats_.bytes_cached += capacity;
+        return;
+    }
+    lock.unlock();
+    ::free(block);
+}
+
+void MemoryPool::set_huge_pages(bool on) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    huge_pages_ = on;
+}
+
+void MemoryPool::set_max_cached_bytes(size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    max_cached_bytes_ = bytes;
+}
+
+MemoryPool::Stats MemoryPool::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void MemoryPool::Trim() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (std::vector<char *> &free_list : free_lists_) {
+        for (char *block : free_list) {
+            ::free(block);
+        }
+        free_list.clear();
+    }
+    stats_.bytes_cached = 0;
+}
+
+char *MemoryPool::MapLarge(size_t capacity) {
+    void *block = ::mmap(nullptr, capacity, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (block == MAP_FAILED) {
+        LOG_SYSERR << "MemoryPool::MapLarge " << capacity;
+        return nullptr;
+    }
+    return static_cast<char *>(block);
+}
+
+} // namespace event_loop
+} // namespace muduo
@@ -0,0 +1,88 @@
+#ifndef __MUDUO_MEMORY_POOL_H_
+#define __MUDUO_MEMORY_POOL_H_
+
+#include "noncopyable.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace muduo {
+namespace event_loop {
+
+///
+/// Size classed memory blocks for I/O buffers, one pool per EventLoop.
+///
+/// Requests are rounded up to a power of two between kMinBlockSize and
+/// kMaxPooledSize, and freed blocks are cached per class for reuse. Larger
+/// blocks are mapped directly, on transparent huge pages if enabled.
+/// Memory is never zero filled.
+///
+/// Thread safe, though blocks are normally taken and returned in the loop
+/// thread. Holders keep the pool alive with a shared_ptr, so blocks may
+/// outlive the EventLoop.
+///
+class MemoryPool : Noncopyable {
+public:
+    static const size_t kMinBlockSize = 2048;
+    static const size_t kMaxPooledSize = 1024 * 1024;
+    static const size_t kHugePageSize = 2 * 1024 * 1024;
+
+    struct Stats {
+        // Allocate() calls, and those served from a free list
+        uint64_t allocations;
+        uint64_t pool_hits;
+        uint64_t deallocations;
+        // blocks handed out and not returned yet
+        size_t bytes_in_use;
+        // free blocks cached for reuse
+        size_t bytes_cached;
+        // directly mapped large blocks, and those advised as huge pages
+        uint64_t large_allocations;
+        uint64_t huge_page_allocations;
+    };
+
+    MemoryPool();
+    ~MemoryPool();
+
+    ///
+    /// Allocates at least @c size bytes.
+    /// @param capacity usable size of the block, pass it to Deallocate()
+    /// @return nullptr if out of memory
+    ///
+    char *Allocate(size_t size, size_t *capacity);
+    void Deallocate(char *block, size_t capacity);
+
+    /// Maps blocks of kHugePageSize or more with MADV_HUGEPAGE.
+    void set_huge_pages(bool on);
+    /// Upper bound of free memory kept for reuse, 32MB by default.
+    void set_max_cached_bytes(size_t bytes);
+
+    Stats stats() const;
+
+    /// Releases all cached free blocks to the system.
+    void Trim();
+
+    /// Block size actually used for a request of @c size bytes.
+    static size_t RoundUp(size_t size);
+
+private:
+    static int ClassIndex(size_t capacity);
+
+    char *MapLarge(size_t capacity);
+    void UndoAllocation(size_t capacity);
+
+    static const int kNumClasses = 10; // 2KB ... 1MB
+
+    mutable std::mutex mutex_;
+    std::vector<char *> free_lists_[kNumClasses];
+    bool huge_pages_;
+    size_t max_cached_bytes_;
+    Stats stats_;
+};
+
+} // namespace event_loop
+} // namespace muduo
+
+#endif /* __MUDUO_MEMORY_POOL_H_ */
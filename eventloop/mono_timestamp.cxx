@@ -0,0 +1,39 @@
+#include "mono_timestamp.h"
+
+#include <cstdio>
+
+namespace muduo {
+namespace event_loop {
+
+struct timespec MonoTimestamp::ToTimespec() const {
+    struct timespec ts;
+    ts.tv_sec = static_cast<time_t>(nanoseconds_ / kNanoSecondsPerSecond);
+    ts.tv_nsec = static_cast<long>(nanoseconds_ % kNanoSecondsPerSecond);
+    return ts;
+}
+
+std::string MonoTimestamp::ToString() const {
+    char buf[32] = {0};
+
+    snprintf(buf, sizeof(buf), "%ld.%09ld",
+             static_cast<long>(nanoseconds_ / kNanoSecondsPerSecond),
+             static_cast<long>(nanoseconds_ % kNanoSecondsPerSecond));
+    return buf;
+}
+
+MonoTimestamp MonoTimestamp::Now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return MonoTimestamp(static_cast<int64_t>(ts.tv_sec) *
+                             kNanoSecondsPerSecond +
+                         ts.tv_nsec);
+}
+
+MonoTimestamp MonoTimestamp::FromTimestamp(Timestamp when) {
+    int64_t delta =
+        when.NanosecondsSinceEpoch() - Timestamp::Now().NanosecondsSinceEpoch();
+    return Now() + delta;
+}
+
+} // namespace event_loop
+} // namespace muduo
@@ -0,0 +1,82 @@
+#ifndef __MUDUO_MONO_TIMESTAMP_H_
+#define __MUDUO_MONO_TIMESTAMP_H_
+
+#include "constants.h"
+#include "timestamp.h"
+
+#include <cstdint>
+#include <ctime>
+#include <string>
+
+namespace muduo {
+namespace event_loop {
+
+///
+/// A point on CLOCK_MONOTONIC, in integer nanoseconds.
+///
+/// Used for scheduling, it is immune to wall clock jumps and compares as a
+/// plain integer. Use Timestamp for wall clock time.
+///
+class MonoTimestamp {
+public:
+    MonoTimestamp() : nanoseconds_(0) {}
+
+    explicit MonoTimestamp(int64_t nanoseconds) : nanoseconds_(nanoseconds) {}
+
+    bool Valid() const { return nanoseconds_ > 0; }
+
+    int64_t nanoseconds() const { return nanoseconds_; }
+
+    struct timespec ToTimespec() const;
+
+    std::string ToString() const;
+
+    static MonoTimestamp Now();
+
+    ///
+    /// Converts a wall clock time to the monotonic clock,
+    /// using the offset between the two clocks right now.
+    ///
+    static MonoTimestamp FromTimestamp(Timestamp when);
+
+private:
+    int64_t nanoseconds_;
+};
+
+inline bool operator<(MonoTimestamp lhs, MonoTimestamp rhs) {
+    return lhs.nanoseconds() < rhs.nanoseconds();
+}
+
+inline bool operator>(MonoTimestamp lhs, MonoTimestamp rhs) {
+    return lhs.nanoseconds() > rhs.nanoseconds();
+}
+
+inline bool operator==(MonoTimestamp lhs, MonoTimestamp rhs) {
+    return lhs.nanoseconds() == rhs.nanoseconds();
+}
+
+inline bool operator!=(MonoTimestamp lhs, MonoTimestamp rhs) {
+    return lhs.nanoseconds() != rhs.nanoseconds();
+}
+
+/// @return difference in nanoseconds
+inline int64_t operator-(MonoTimestamp high, MonoTimestamp low) {
+    return high.nanoseconds() - low.nanoseconds();
+}
+
+inline MonoTimestamp operator+(MonoTimestamp ts, int64_t nanoseconds) {
+    return MonoTimestamp(ts.nanoseconds() + nanoseconds);
+}
+
+inline MonoTimestamp operator-(MonoTimestamp ts, int64_t nanoseconds) {
+    return MonoTimestamp(ts.nanoseconds() - nanoseconds);
+}
+
+inline int64_t SecondsToNanoseconds(double seconds) {
+    return static_cast<int64_t>(seconds * kNanoSecondsPerSecond);
+}
+
+} // namespace event_loop
+} // namespace muduo
+
+#endif /* __MUDUO_MONO_TIMESTAMP_H_ */
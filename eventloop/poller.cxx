@@ -1,7 +1,7 @@
 #include "poller.h"
 #include "channel.h"
-#include "timestamp.h"
 
+#include <cerrno>
 #include <chrono>
 #include <cstring>
 #include <sys/poll.h>
@@ -35,11 +35,10 @@ EpollPoller::~EpollPoller() {
     }
 }
 
-Timestamp EpollPoller::Poll(int timeout, ChannelList *active_channels) {
+int EpollPoller::Poll(int timeout, ChannelList *active_channels) {
     int numEvents = ::epoll_wait(epoll_fd_, &*events_.begin(),
                                  static_cast<int>(events_.size()), timeout);
     int savedErrno = errno;
-    Timestamp now = Timestamp::Now();
 
     if (numEvents > 0) {
         for (int i = 0; i < numEvents; ++i) {
@@ -58,8 +57,9 @@ Timestamp EpollPoller::Poll(int timeout, ChannelList *active_channels) {
         if (savedErrno != EINTR) {
             errno = savedErrno;
         }
+        numEvents = 0;
     }
-    return now;
+    return numEvents;
 }
 
 void EpollPoller::UpdateChannel(Channel *channel) {
@@ -21,7 +21,8 @@ public:
     Poller(EventLoop *loop);
     virtual ~Poller() = default;
 
-    virtual Timestamp Poll(int timeout, ChannelList *active_channels) = 0;
+    /// @return number of active channels, the loop reads the clock itself
+    virtual int Poll(int timeout, ChannelList *active_channels) = 0;
 
     virtual void UpdateChannel(Channel *channel) = 0;
     virtual void RemoveChannel(Channel *channel) = 0;
@@ -40,7 +41,7 @@ public:
     EpollPoller(EventLoop *loop);
     ~EpollPoller();
 
-    Timestamp Poll(int timeout, ChannelList *active_channels) override;
+    int Poll(int timeout, ChannelList *active_channels) override;
 
     void UpdateChannel(Channel *channel) override;
     void RemoveChannel(Channel *channel) override;
@@ -0,0 +1,159 @@
+#include "precision_timer.h"
+#include "channel.h"
+#include "event_loop.h"
+#include "import_log.h"
+
+#include <cstdio>
+#include <cstring>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+namespace muduo {
+namespace event_loop {
+
+namespace {
+
+inline void CpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+} // namespace
+
+const int64_t PrecisionTimer::kHistogramBounds[kHistogramBuckets] = {
+    1000, 2000, 5000, 10000, 20000, 50000, 100000, INT64_MAX};
+
+std::string PrecisionTimer::Stats::ToString() const {
+    char buf[512];
+    int n = snprintf(buf, sizeof buf,
+                     "count %ld min %ldns max %ldns mean %.0fns "
+                     "spin %ldns late %ld |",
+                     static_cast<long>(count),
+                     static_cast<long>(count ? min_jitter : 0),
+                     static_cast<long>(max_jitter), MeanJitter(),
+                     static_cast<long>(total_spin),
+                     static_cast<long>(late_wakeups));
+    for (int i = 0; i < kHistogramBuckets && n < (int)sizeof buf; ++i) {
+        if (i + 1 < kHistogramBuckets) {
+            n += snprintf(buf + n, sizeof buf - n, " <=%ldus:%ld",
+                          static_cast<long>(kHistogramBounds[i] /
+                                            kNanoSecondsPerMicroSecond),
+                          static_cast<long>(histogram[i]));
+        } else {
+            n += snprintf(buf + n, sizeof buf - n, " more:%ld",
+                          static_cast<long>(histogram[i]));
+        }
+    }
+    return buf;
+}
+
+PrecisionTimer::PrecisionTimer(EventLoop *loop, TimerCallback cb)
+    : loop_(loop),
+      cb_(std::move(cb)),
+      timer_fd_(::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC)),
+      channel_(new Channel(loop, timer_fd_)),
+      interval_(0),
+      spin_threshold_(50 * kNanoSecondsPerMicroSecond) {
+    ResetStats();
+    channel_->set_read_callback(std::bind(&PrecisionTimer::HandleRead, this));
+    channel_->EnableReading();
+}
+
+PrecisionTimer::~PrecisionTimer() {
+    channel_->DisableAll();
+    channel_->RemoveFromLoop();
+    ::close(timer_fd_);
+}
+
+void PrecisionTimer::Start(MonoTimestamp when, int64_t interval) {
+    loop_->AssertInLoopThread();
+    deadline_ = when;
+    interval_ = interval > 0 ? interval : 0;
+    Arm();
+}
+
+void PrecisionTimer::Stop() {
+    loop_->AssertInLoopThread();
+    deadline_ = MonoTimestamp();
+    struct itimerspec value;
+    ::bzero(&value, sizeof value);
+    ::timerfd_settime(timer_fd_, 0, &value, nullptr);
+}
+
+void PrecisionTimer::ResetStats() {
+    ::bzero(&stats_, sizeof stats_);
+    stats_.min_jitter = INT64_MAX;
+}
+
+void PrecisionTimer::Arm() {
+    MonoTimestamp wakeup = deadline_ - spin_threshold_;
+    struct itimerspec value;
+    ::bzero(&value, sizeof value);
+    // zero disarms timerfd, a passed absolute time fires immediately
+    value.it_value =
+        wakeup.Valid() ? wakeup.ToTimespec() : MonoTimestamp(1).ToTimespec();
+    if (::timerfd_settime(timer_fd_, TFD_TIMER_ABSTIME, &value, nullptr) < 0) {
+        LOG_SYSERR << "PrecisionTimer::Arm";
+    }
+}
+
+void PrecisionTimer::HandleRead() {
+    loop_->AssertInLoopThread();
+    uint64_t howmany;
+    ssize_t n = ::read(timer_fd_, &howmany, sizeof howmany);
+    if (n != sizeof howmany || !deadline_.Valid()) {
+        // stopped or re-armed meanwhile
+        return;
+    }
+
+    MonoTimestamp woken = MonoTimestamp::Now();
+    MonoTimestamp now = woken;
+    while (now < deadline_) {
+        CpuRelax();
+        now = MonoTimestamp::Now();
+    }
+    Record(now - deadline_, now - woken, woken > deadline_);
+
+    MonoTimestamp fired = deadline_;
+    if (interval_ > 0) {
+        // pace from the deadline, not from now, so that jitter doesn't
+        // accumulate. skip the periods we are too late for.
+        deadline_ = fired + interval_;
+        if (deadline_ < now) {
+            deadline_ = deadline_ + ((now - deadline_) / interval_ + 1) *
+                                        interval_;
+        }
+        Arm();
+    } else {
+        deadline_ = MonoTimestamp();
+    }
+
+    cb_();
+}
+
+void PrecisionTimer::Record(int64_t jitter, int64_t spin, bool late) {
+    ++stats_.count;
+    if (jitter < stats_.min_jitter) {
+        stats_.min_jitter = jitter;
+    }
+    if (jitter > stats_.max_jitter) {
+        stats_.max_jitter = jitter;
+    }
+    stats_.total_jitter += jitter;
+    stats_.total_spin += spin;
+    if (late) {
+        ++stats_.late_wakeups;
+    }
+    for (int i = 0; i < kHistogramBuckets; ++i) {
+        if (jitter <= kHistogramBounds[i]) {
+            ++stats_.histogram[i];
+            break;
+        }
+    }
+}
+
+} // namespace event_loop
+} // namespace muduo
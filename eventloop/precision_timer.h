@@ -0,0 +1,91 @@
+#ifndef __MUDUO_PRECISION_TIMER_H_
+#define __MUDUO_PRECISION_TIMER_H_
+
+#include "callback.h"
+#include "mono_timestamp.h"
+#include "noncopyable.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace muduo {
+namespace event_loop {
+
+class Channel;
+class EventLoop;
+
+///
+/// A timer accurate to a few microseconds, for pacing.
+///
+/// It owns a timerfd armed @c spin_threshold before the deadline, and busy
+/// waits on CLOCK_MONOTONIC for the rest of the way. The loop is blocked
+/// while spinning, so keep the threshold as small as the wakeup latency of
+/// the machine allows.
+///
+/// Not thread safe, use it in the loop thread only.
+///
+class PrecisionTimer : Noncopyable {
+public:
+    // upper bounds of the jitter histogram buckets, in nanoseconds
+    static const int kHistogramBuckets = 8;
+    static const int64_t kHistogramBounds[kHistogramBuckets];
+
+    /// Achieved jitter, the time the callback ran minus its deadline.
+    struct Stats {
+        int64_t count;
+        int64_t min_jitter;
+        int64_t max_jitter;
+        int64_t total_jitter;
+        // time spent busy waiting
+        int64_t total_spin;
+        // kernel woke us after the deadline, there was nothing to spin
+        int64_t late_wakeups;
+        // jitter <= kHistogramBounds[i], the last one counts the rest
+        int64_t histogram[kHistogramBuckets];
+
+        double MeanJitter() const {
+            return count ? static_cast<double>(total_jitter) / count : 0.0;
+        }
+        std::string ToString() const;
+    };
+
+    PrecisionTimer(EventLoop *loop, TimerCallback cb);
+    ~PrecisionTimer();
+
+    ///
+    /// Runs callback at @c when, then every @c interval nanoseconds if
+    /// @c interval > 0. Restarting replaces the previous schedule.
+    ///
+    void Start(MonoTimestamp when, int64_t interval = 0);
+    void Stop();
+    bool active() const { return deadline_.Valid(); }
+
+    /// How early the kernel timer fires, 50us by default.
+    void set_spin_threshold(int64_t nanoseconds) {
+        spin_threshold_ = nanoseconds;
+    }
+
+    const Stats &stats() const { return stats_; }
+    void ResetStats();
+
+private:
+    void HandleRead();
+    void Arm();
+    void Record(int64_t jitter, int64_t spin, bool late);
+
+    EventLoop *loop_;
+    TimerCallback cb_;
+    const int timer_fd_;
+    std::unique_ptr<Channel> channel_;
+
+    MonoTimestamp deadline_;
+    int64_t interval_;
+    int64_t spin_threshold_;
+    Stats stats_;
+};
+
+} // namespace event_loop
+} // namespace muduo
+
+#endif /* __MUDUO_PRECISION_TIMER_H_ */
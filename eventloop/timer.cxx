@@ -1,8 +1,6 @@
 #include "timer.h"
 #include "channel.h"
 #include "event_loop.h"
-#include "timespec.h"
-#include "timestamp.h"
 
 #include <sys/timerfd.h>
 #include <unistd.h>
@@ -14,11 +12,18 @@ namespace event_loop {
 
 std::atomic_int64_t Timer::s_num(0);
 
-void Timer::Restart(Timestamp now) {
+void Timer::Restart(MonoTimestamp now) {
     if (repeat_) {
-        expiration_ = now + interval_;
+        // pace from the previous expiration, not from now, so that the slack
+        // and the wakeup latency don't stretch the period. skip the periods
+        // we are too late for.
+        expiration_ = expiration_ + interval_;
+        if (expiration_ < now) {
+            expiration_ = expiration_ + ((now - expiration_) / interval_ + 1) *
+                                            interval_;
+        }
     } else {
-        expiration_ = Timestamp(); // invalid
+        expiration_ = MonoTimestamp(); // invalid
     }
 }
 
@@ -2,8 +2,8 @@
 #define __MUDUO_TIMER_H_
 
 #include "callback.h"
+#include "mono_timestamp.h"
 #include "noncopyable.h"
-#include "timestamp.h"
 
 #include <atomic>
 #include <memory>
@@ -13,23 +13,29 @@ namespace event_loop {
 
 class EventLoop;
 class Channel;
-class Timestamp;
 
 class Timer : Noncopyable {
 public:
-    Timer(TimerCallback cb, Timestamp when, double interval)
+    /// @param interval repeating interval in nanoseconds, 0 for one shot
+    /// @param slack tolerated lateness in nanoseconds
+    Timer(TimerCallback cb, MonoTimestamp when, int64_t interval,
+          int64_t slack = 0)
         : cb_(std::move(cb)),
           expiration_(when),
           interval_(interval),
-          repeat_(interval > 0.0),
+          slack_(slack > 0 ? slack : 0),
+          repeat_(interval > 0),
           sequence_(++s_num) {}
     ~Timer() {}
 
     void Run() const { cb_(); }
 
-    void Restart(Timestamp now);
+    void Restart(MonoTimestamp now);
 
-    Timestamp expiration() const { return expiration_; }
+    MonoTimestamp expiration() const { return expiration_; }
+    /// The latest time this timer may fire, expiration plus its slack.
+    MonoTimestamp deadline() const { return expiration_ + slack_; }
+    int64_t slack() const { return slack_; }
     bool repeat() const { return repeat_; }
     int64_t sequence() const { return sequence_; }
 
@@ -37,8 +43,10 @@ public:
 
 private:
     const TimerCallback cb_;
-    Timestamp expiration_;
-    const double interval_;
+    MonoTimestamp expiration_;
+    const int64_t interval_;
+    // tolerated lateness, like linux timerslack
+    const int64_t slack_;
     const bool repeat_;
     const int64_t sequence_;
 
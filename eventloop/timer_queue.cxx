@@ -18,18 +18,21 @@ int CreateTimerfd() {
     return timerfd;
 }
 
-void ResetTimerfd(int timerfd, Timestamp expiration) {
+void ResetTimerfd(int timerfd, MonoTimestamp expiration) {
     // wake up loop by timerfd_settime()
+    // expiration is on CLOCK_MONOTONIC as timerfd is, so arm it with the
+    // absolute time, an expiration already passed fires immediately.
     struct itimerspec new_value;
     struct itimerspec old_value;
     ::bzero(&new_value, sizeof new_value);
     ::bzero(&old_value, sizeof old_value);
-    new_value.it_value = Timestamp::HowMuchTimeFromNow(expiration);
-    int ret = ::timerfd_settime(timerfd, 0, &new_value, &old_value);
+    new_value.it_value = expiration.ToTimespec();
+    int ret = ::timerfd_settime(timerfd, TFD_TIMER_ABSTIME, &new_value,
+                                &old_value);
     (void)ret;
 }
 
-void ReadTimerfd(int timerfd, Timestamp now) {
+bool ReadTimerfd(int timerfd, MonoTimestamp now) {
     uint64_t howmany;
     ssize_t n = ::read(timerfd, &howmany, sizeof howmany);
     LOG_TRACE << "TimerQueue::handleRead() " << howmany << " at "
@@ -37,7 +40,9 @@ void ReadTimerfd(int timerfd, Timestamp now) {
     if (n != sizeof howmany) {
         LOG_ERROR << "TimerQueue::HandleRead() reads " << n
                   << " bytes instead of 8";
+        return false;
     }
+    return true;
 }
 
 } // namespace details
@@ -59,10 +64,10 @@ TimerQueue::~TimerQueue() {
     ::close(timer_fd_);
 }
 
-TimerId TimerQueue::AddTimer(TimerCallback cb, Timestamp when,
-                             double interval) {
+TimerId TimerQueue::AddTimer(TimerCallback cb, MonoTimestamp when,
+                             int64_t interval, int64_t slack) {
 
-    Timer *timer = new Timer(std::move(cb), when, interval);
+    Timer *timer = new Timer(std::move(cb), when, interval, slack);
     loop_->RunInLoop(std::bind(&TimerQueue::AddTimerInLoop, this, timer));
     return TimerId(timer, timer->sequence());
 }
@@ -73,10 +78,12 @@ void TimerQueue::Cancel(TimerId timerId) {
 
 void TimerQueue::AddTimerInLoop(Timer *timer) {
     loop_->AssertInLoopThread();
-    bool earliest_changed = Insert(timer);
+    Insert(timer);
 
-    if (earliest_changed) {
-        details::ResetTimerfd(timer_fd_, timer->expiration());
+    // the batch boundary only moves if the new timer can't wait for it
+    MonoTimestamp deadline = timer->deadline();
+    if (!armed_.Valid() || deadline < armed_) {
+        Rearm(deadline);
     }
 }
 
@@ -85,7 +92,7 @@ bool TimerQueue::Insert(Timer *timer) {
     assert(timers_.size() == active_timers_.size());
 
     bool earliest_changed = false;
-    Timestamp when = timer->expiration();
+    MonoTimestamp when = timer->expiration();
     TimerList::iterator it = timers_.begin();
     if (it == timers_.end() || when < it->first) {
         earliest_changed = true;
@@ -126,8 +133,15 @@ void TimerQueue::CancelInLoop(TimerId timer_id) {
 
 void TimerQueue::HandleRead() {
     loop_->AssertInLoopThread();
-    Timestamp now(Timestamp::Now());
-    details::ReadTimerfd(timer_fd_, now);
+    // we are called right after poll returned, the loop clock is fresh.
+    MonoTimestamp now(loop_->LoopMonoNow());
+    if (details::ReadTimerfd(timer_fd_, now) && now < armed_) {
+        // timerfd fired, so the armed time has passed even if the (coarse)
+        // loop clock hasn't caught up with it yet.
+        now = armed_;
+    }
+    // timerfd is one-shot, it's disarmed now
+    armed_ = MonoTimestamp();
 
     std::vector<Entry> expired = GetExpired(now);
 
@@ -142,7 +156,7 @@ void TimerQueue::HandleRead() {
     Reset(expired, now);
 }
 
-std::vector<TimerQueue::Entry> TimerQueue::GetExpired(Timestamp now) {
+std::vector<TimerQueue::Entry> TimerQueue::GetExpired(MonoTimestamp now) {
     assert(timers_.size() == active_timers_.size());
     std::vector<Entry> expired;
     Entry sentry(now, reinterpret_cast<Timer *>(UINTPTR_MAX));
@@ -163,9 +177,7 @@ std::vector<TimerQueue::Entry> TimerQueue::GetExpired(Timestamp now) {
 }
 
 void TimerQueue::Reset(const std::vector<TimerQueue::Entry> &expired,
-                       Timestamp now) {
-    Timestamp next_expire;
-
+                       MonoTimestamp now) {
     for (const Entry &it : expired) {
         ActiveTimer timer(it.second, it.second->sequence());
         if (it.second->repeat() &&
@@ -178,13 +190,34 @@ void TimerQueue::Reset(const std::vector<TimerQueue::Entry> &expired,
         }
     }
 
-    if (!timers_.empty()) {
-        next_expire = timers_.begin()->second->expiration();
+    MonoTimestamp next_wakeup = NextWakeup();
+    if (next_wakeup.Valid()) {
+        Rearm(next_wakeup);
+    }
+}
+
+MonoTimestamp TimerQueue::NextWakeup() const {
+    MonoTimestamp wakeup;
+    // timers_ is ordered by expiration, and a deadline is never earlier than
+    // its expiration, so stop at the first timer expiring after the boundary.
+    for (const Entry &it : timers_) {
+        if (wakeup.Valid() && !(it.first < wakeup)) {
+            break;
+        }
+        MonoTimestamp deadline = it.second->deadline();
+        if (!wakeup.Valid() || deadline < wakeup) {
+            wakeup = deadline;
+        }
     }
+    return wakeup;
+}
 
-    if (next_expire.Valid()) {
-        details::ResetTimerfd(timer_fd_, next_expire);
+void TimerQueue::Rearm(MonoTimestamp wakeup) {
+    if (armed_.Valid() && wakeup == armed_) {
+        return;
     }
+    armed_ = wakeup;
+    details::ResetTimerfd(timer_fd_, wakeup);
 }
 
 } // namespace event_loop
@@ -5,7 +5,7 @@
 #include "channel.h"
 #include "noncopyable.h"
 #include "timer_id.h"
-#include "timestamp.h"
+#include "mono_timestamp.h"
 
 #include <set>
 #include <vector>
@@ -23,10 +23,14 @@ public:
 
     ///
     /// Schedules the callback to be run at given time,
-    /// repeats if @c interval > 0.0.
+    /// repeats every @c interval nanoseconds if @c interval > 0.
+    ///
+    /// The timer may fire up to @c slack nanoseconds late, so that timers
+    /// with nearby deadlines are served by a single timerfd wakeup.
     ///
     /// Must be thread safe. Usually be called from other threads.
-    TimerId AddTimer(TimerCallback cb, Timestamp when, double interval);
+    TimerId AddTimer(TimerCallback cb, MonoTimestamp when, int64_t interval,
+                     int64_t slack = 0);
 
     void Cancel(TimerId timerId);
 
@@ -34,7 +38,7 @@ private:
     // FIXME: use unique_ptr<Timer> instead of raw pointers.
     // This requires heterogeneous comparison lookup (N3465) from C++14
     // so that we can find an T* in a set<unique_ptr<T>>.
-    using Entry = std::pair<Timestamp, Timer *>;
+    using Entry = std::pair<MonoTimestamp, Timer *>;
     using TimerList = std::set<Entry>;
     using ActiveTimer = std::pair<Timer *, int64_t>;
     using ActiveTimerSet = std::set<ActiveTimer>;
@@ -46,14 +50,20 @@ private:
     // called when timerfd alarms
     void HandleRead();
     // move out all expired timers
-    std::vector<Entry> GetExpired(Timestamp now);
-    void Reset(const std::vector<Entry> &expired, Timestamp now);
+    std::vector<Entry> GetExpired(MonoTimestamp now);
+    void Reset(const std::vector<Entry> &expired, MonoTimestamp now);
+    // earliest deadline among the timers, the end of the next batch
+    MonoTimestamp NextWakeup() const;
+    // re-arms timerfd only when the batch boundary changes
+    void Rearm(MonoTimestamp wakeup);
 
 private:
     EventLoop *loop_;
     const int timer_fd_;
     std::unique_ptr<Channel> channel_;
     TimerList timers_;
+    // time timerfd is currently armed for, invalid if disarmed
+    MonoTimestamp armed_;
 
     // for cancel()
     ActiveTimerSet active_timers_;
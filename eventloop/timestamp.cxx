@@ -6,68 +6,71 @@
 namespace muduo {
 namespace event_loop {
 
-Timestamp::Timestamp() : ts_({0, 0}) {}
+Timestamp::Timestamp() : nanoseconds_(0) {}
 
-Timestamp::Timestamp(int64_t nanoseconds)
-    : ts_({static_cast<time_t>(nanoseconds / kNanoSecondsPerSecond),
-           static_cast<long>(nanoseconds % kNanoSecondsPerSecond)}) {}
+Timestamp::Timestamp(int64_t nanoseconds) : nanoseconds_(nanoseconds) {}
 
-Timestamp::Timestamp(const struct timespec &ts) : ts_(ts) {}
+Timestamp::Timestamp(const struct timespec &ts)
+    : nanoseconds_(static_cast<int64_t>(ts.tv_sec) * kNanoSecondsPerSecond +
+                   ts.tv_nsec) {}
 
 Timestamp::~Timestamp() {}
 
-bool Timestamp::Valid() const { return ts_.tv_sec > 0 && ts_.tv_nsec >= 0; }
+bool Timestamp::Valid() const { return nanoseconds_ >= kNanoSecondsPerSecond; }
 
-int64_t Timestamp::NanosecondsSinceEpoch() const {
-    return static_cast<int64_t>(ts_.tv_sec) * kNanoSecondsPerSecond +
-           ts_.tv_nsec;
-}
+int64_t Timestamp::NanosecondsSinceEpoch() const { return nanoseconds_; }
 
 int64_t Timestamp::MicrosecondsSinceEpoch() const {
-    return static_cast<int64_t>(ts_.tv_sec) * kMicroSecondsPerSecond +
-           ts_.tv_nsec / kNanoSecondsPerMicroSecond;
+    return nanoseconds_ / kNanoSecondsPerMicroSecond;
 }
 
 int64_t Timestamp::MillisecondsSinceEpoch() const {
-    return static_cast<int64_t>(ts_.tv_sec) * kMilliSecondsPerSecond +
-           ts_.tv_nsec / kNanoSecondsPerMilliSecond;
+    return nanoseconds_ / kNanoSecondsPerMilliSecond;
 }
 
-time_t Timestamp::SecondsSinceEpoch() const { return ts_.tv_sec; }
+time_t Timestamp::SecondsSinceEpoch() const {
+    return static_cast<time_t>(nanoseconds_ / kNanoSecondsPerSecond);
+}
 
 std::string Timestamp::ToString() const {
     char buf[32] = {0};
 
-    snprintf(buf, sizeof(buf), "%ld.%09ld", ts_.tv_sec, ts_.tv_nsec);
+    snprintf(buf, sizeof(buf), "%ld.%09ld",
+             static_cast<long>(nanoseconds_ / kNanoSecondsPerSecond),
+             static_cast<long>(nanoseconds_ % kNanoSecondsPerSecond));
     return buf;
 }
 
 std::string Timestamp::ToFormattedString() const {
-    std::tm *bt = localtime(&ts_.tv_sec);
+    time_t seconds = SecondsSinceEpoch();
+    std::tm *bt = localtime(&seconds);
     std::ostringstream oss;
     // https://en.cppreference.com/w/cpp/io/manip/put_time
     oss << std::put_time(bt, "%F %T");
-    oss << "." << std::setfill('0') << std::setw(9) << ts_.tv_nsec;
+    oss << "." << std::setfill('0') << std::setw(9)
+        << nanoseconds_ % kNanoSecondsPerSecond;
     return oss.str();
 }
 
 std::string Timestamp::ToFormattedMilliSecondsString() const {
-    std::tm *bt = localtime(&ts_.tv_sec);
+    time_t seconds = SecondsSinceEpoch();
+    std::tm *bt = localtime(&seconds);
     std::ostringstream oss;
     // https://en.cppreference.com/w/cpp/io/manip/put_time
     oss << std::put_time(bt, "%F %T");
     oss << "." << std::setfill('0') << std::setw(3)
-        << ts_.tv_nsec / kNanoSecondsPerMilliSecond;
+        << nanoseconds_ % kNanoSecondsPerSecond / kNanoSecondsPerMilliSecond;
     return oss.str();
 }
 
 std::string Timestamp::ToFormattedMicroSecondsString() const {
-    std::tm *bt = localtime(&ts_.tv_sec);
+    time_t seconds = SecondsSinceEpoch();
+    std::tm *bt = localtime(&seconds);
     std::ostringstream oss;
     // https://en.cppreference.com/w/cpp/io/manip/put_time
     oss << std::put_time(bt, "%F %T");
     oss << "." << std::setfill('0') << std::setw(6)
-        << ts_.tv_nsec / kNanoSecondsPerMicroSecond;
+        << nanoseconds_ % kNanoSecondsPerSecond / kNanoSecondsPerMicroSecond;
     return oss.str();
 }
 
@@ -52,12 +52,13 @@ public:
 
     static struct timespec HowMuchTimeFromNow(Timestamp when);
 
-    bool operator==(const Timestamp &rhs) {
-        return ts_.tv_sec == rhs.ts_.tv_sec && ts_.tv_nsec == rhs.ts_.tv_nsec;
+    bool operator==(const Timestamp &rhs) const {
+        return nanoseconds_ == rhs.nanoseconds_;
     }
 
 private:
-    struct timespec ts_;
+    // kept as a single integer, so comparisons don't multiply out a timespec
+    int64_t nanoseconds_;
 };
 
 inline bool operator<(const Timestamp &lhs, const Timestamp &rhs) {
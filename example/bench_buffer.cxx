@@ -0,0 +1,222 @@
+// Benchmarks for net::Buffer: Append growth, ReadFd from a socketpair,
+// MakeSpace compaction, FindCRLF and the Retrieve* conversions.
+//
+// usage: bench_buffer [megabytes]
+//   megabytes  data moved per measurement, default 256
+
+#include "eventloop/memory_pool.h"
+#include "eventloop/mono_timestamp.h"
+#include "net/buffer.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace muduo;
+using namespace muduo::net;
+using event_loop::MemoryPool;
+using event_loop::MonoTimestamp;
+
+static size_t g_total = 256 << 20;
+
+static double GBps(size_t bytes, int64_t nanoseconds) {
+    return double(bytes) / nanoseconds;
+}
+
+// Appends chunks into fresh buffers growing to 4MB each.
+static void BenchAppend(size_t chunk,
+                        const std::shared_ptr<MemoryPool> &pool) {
+    const size_t kBufferSize = 4 << 20;
+    std::string data(chunk, 'x');
+    size_t appends = 0;
+    MonoTimestamp start = MonoTimestamp::Now();
+    for (size_t done = 0; done < g_total; done += kBufferSize) {
+        Buffer buffer(pool);
+        for (size_t n = 0; n < kBufferSize; n += chunk) {
+            buffer.Append(data.data(), chunk);
+            ++appends;
+        }
+    }
+    int64_t elapsed = MonoTimestamp::Now() - start;
+    printf("  chunk %6zu %-8s %6.1f ns/append %6.2f GB/s\n", chunk,
+           pool ? "pooled" : "malloc", double(elapsed) / appends,
+           GBps(g_total, elapsed));
+}
+
+// A writer thread streams messages into a socketpair, ReadFd drains it.
+static void BenchReadFd(size_t message, const char *mode) {
+    int fds[2];
+    if (::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) < 0) {
+        perror("socketpair");
+        exit(1);
+    }
+    std::thread writer([fds, message]() {
+        std::string data(message, 'x');
+        for (size_t sent = 0; sent < g_total; sent += message) {
+            size_t n = 0;
+            while (n < message) {
+                ssize_t k = ::write(fds[0], data.data() + n, message - n);
+                if (k <= 0) {
+                    return;
+                }
+                n += k;
+            }
+        }
+    });
+
+    std::unique_ptr<char[]> scratch(new char[256 * 1024]);
+    Buffer buffer(std::make_shared<MemoryPool>());
+    if (std::string(mode) == "ring") {
+        buffer.EnableRing(256 * 1024);
+    }
+    size_t received = 0;
+    size_t reads = 0;
+    int saved_errno = 0;
+    MonoTimestamp start = MonoTimestamp::Now();
+    while (received < g_total) {
+        ssize_t n = std::string(mode) == "stack"
+                        ? buffer.ReadFd(fds[1], &saved_errno)
+                        : buffer.ReadFd(fds[1], &saved_errno, scratch.get(),
+                                        256 * 1024);
+        if (n <= 0) {
+            break;
+        }
+        received += n;
+        ++reads;
+        // consume whole messages like a codec would
+        buffer.Retrieve(buffer.ReadableBytes() / message * message);
+    }
+    int64_t elapsed = MonoTimestamp::Now() - start;
+    writer.join();
+    ::close(fds[0]);
+    ::close(fds[1]);
+    printf("  message %6zu %-8s %6.2f GB/s %8zu bytes/read\n", message, mode,
+           GBps(received, elapsed), received / reads);
+}
+
+// Each cycle appends a message, then retrieves all but @c left bytes, so
+// MakeSpace compacts @c left bytes to the front whenever space runs out.
+static void BenchMakeSpace(size_t left, bool ring) {
+    const size_t kMessage = 16 * 1024;
+    Buffer buffer(std::shared_ptr<MemoryPool>(), 64 * 1024);
+    if (ring) {
+        buffer.EnableRing(64 * 1024);
+    }
+    std::string data(kMessage, 'x');
+    buffer.Append(data.data(), left);
+    size_t cycles = g_total / kMessage;
+    MonoTimestamp start = MonoTimestamp::Now();
+    for (size_t i = 0; i < cycles; ++i) {
+        buffer.Append(data.data(), kMessage);
+        buffer.Retrieve(kMessage);
+    }
+    int64_t elapsed = MonoTimestamp::Now() - start;
+    printf("  keeping %5zu bytes %-6s %6.1f ns/cycle %6.2f GB/s\n", left,
+           ring ? "ring" : "linear", double(elapsed) / cycles,
+           GBps(cycles * kMessage, elapsed));
+}
+
+static void BenchFindCRLF(size_t line_length) {
+    std::string line(line_length - 2, 'x');
+    line += "\r\n";
+    std::string text;
+    while (text.size() < (1 << 20)) {
+        text += line;
+    }
+
+    const char *const kModes[] = {"std::string", "StringPiece"};
+    for (int mode = 0; mode < 2; ++mode) {
+        Buffer buffer;
+        std::string str;
+        StringPiece piece;
+        size_t lines = 0;
+        MonoTimestamp start = MonoTimestamp::Now();
+        for (size_t done = 0; done < g_total; done += text.size()) {
+            buffer.Append(text.data(), text.size());
+            while (mode == 0 ? buffer.RetrieveCRLFLine(false, str)
+                             : buffer.RetrieveCRLFLine(&piece)) {
+                ++lines;
+            }
+        }
+        int64_t elapsed = MonoTimestamp::Now() - start;
+        printf("  lines of %5zu %-12s %6.1f ns/line %6.2f GB/s\n",
+               line_length, kModes[mode], double(elapsed) / lines,
+               GBps(g_total, elapsed));
+    }
+}
+
+static void BenchRetrieve(size_t len) {
+    const char *const kModes[] = {"Retrieve", "AsString", "AsStringPiece",
+                                  "AsSlice"};
+    std::string data(1 << 20, 'x');
+    for (int mode = 0; mode < 4; ++mode) {
+        Buffer buffer(std::make_shared<MemoryPool>());
+        size_t checksum = 0;
+        size_t retrieves = 0;
+        MonoTimestamp start = MonoTimestamp::Now();
+        for (size_t done = 0; done < g_total; done += data.size()) {
+            buffer.Append(data.data(), data.size());
+            while (buffer.ReadableBytes() >= len) {
+                switch (mode) {
+                case 0:
+                    buffer.Retrieve(len);
+                    break;
+                case 1:
+                    checksum += buffer.RetrieveAsString(len).size();
+                    break;
+                case 2:
+                    checksum += buffer.RetrieveAsStringPiece(len).size();
+                    break;
+                default:
+                    checksum += buffer.RetrieveAsSlice(len).size();
+                    break;
+                }
+                ++retrieves;
+            }
+        }
+        int64_t elapsed = MonoTimestamp::Now() - start;
+        printf("  %6zu bytes %-14s %7.1f ns/op (%zu)\n", len, kModes[mode],
+               double(elapsed) / retrieves, checksum);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    g_total = (argc > 1 ? atoi(argv[1]) : 256) * size_t(1 << 20);
+
+    printf("Append growth:\n");
+    for (size_t chunk : {16, 256, 4096, 65536}) {
+        BenchAppend(chunk, nullptr);
+        BenchAppend(chunk, std::make_shared<MemoryPool>());
+    }
+
+    printf("ReadFd from a socketpair:\n");
+    for (size_t message : {64, 1024, 16384, 262144}) {
+        BenchReadFd(message, "stack");
+        BenchReadFd(message, "scratch");
+        BenchReadFd(message, "ring");
+    }
+
+    printf("MakeSpace compaction:\n");
+    for (size_t left : {0, 64, 4096, 32768}) {
+        BenchMakeSpace(left, false);
+        BenchMakeSpace(left, true);
+    }
+
+    printf("FindCRLF via RetrieveCRLFLine:\n");
+    for (size_t line_length : {32, 256, 4096}) {
+        BenchFindCRLF(line_length);
+    }
+
+    printf("Retrieve conversions:\n");
+    for (size_t len : {16, 1024, 65536}) {
+        BenchRetrieve(len);
+    }
+
+    return 0;
+}
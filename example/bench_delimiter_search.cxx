@@ -0,0 +1,163 @@
+// Benchmarks delimiter search in Buffer against std::search, which
+// Buffer::FindCRLF used before, and the libc routines.
+//
+// usage: bench_delimiter_search [megabytes]
+//   megabytes  data scanned per measurement, default 256
+
+#include "eventloop/mono_timestamp.h"
+#include "net/buffer.h"
+#include "net/delimiter_search.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string>
+
+using namespace muduo;
+using namespace muduo::net;
+
+typedef std::function<const char *(const char *, const char *)> Finder;
+
+// text of printable bytes with @c delim every @c line_length bytes or so
+static std::string MakeText(size_t size, size_t line_length,
+                            const std::string &delim) {
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> byte(' ', '~');
+    std::uniform_int_distribution<size_t> length(line_length / 2,
+                                                 line_length * 3 / 2);
+    std::string text;
+    text.reserve(size + line_length * 2);
+    while (text.size() < size) {
+        size_t n = length(rng);
+        for (size_t i = 0; i < n; ++i) {
+            text.push_back(static_cast<char>(byte(rng)));
+        }
+        text += delim;
+    }
+    return text;
+}
+
+// scans all of @c text delimiter by delimiter, @c megabytes in total
+static void Bench(const char *name, const std::string &text, size_t delim_len,
+                  int megabytes, const Finder &find) {
+    const char *end = text.data() + text.size();
+    size_t scanned = 0;
+    size_t found = 0;
+    event_loop::MonoTimestamp start = event_loop::MonoTimestamp::Now();
+    while (scanned < static_cast<size_t>(megabytes) << 20) {
+        const char *p = text.data();
+        while (const char *hit = find(p, end)) {
+            p = hit + delim_len;
+            ++found;
+        }
+        scanned += text.size();
+    }
+    int64_t elapsed = event_loop::MonoTimestamp::Now() - start;
+    printf("  %-24s %7.2f GB/s  (%zu found)\n", name,
+           double(scanned) / elapsed, found);
+}
+
+static void Verify(const std::string &text, const std::string &delim) {
+    const char *end = text.data() + text.size();
+    for (size_t offset = 0; offset < 256 && offset < text.size(); ++offset) {
+        const char *begin = text.data() + offset;
+        const char *expected =
+            std::search(begin, end, delim.data(), delim.data() + delim.size());
+        if (expected == end) {
+            expected = nullptr;
+        }
+        if (search::FindDelimiter(begin, end, delim.data(), delim.size()) !=
+            expected) {
+            fprintf(stderr, "mismatch at offset %zu\n", offset);
+            abort();
+        }
+    }
+}
+
+static void BenchDelimiter(const std::string &delim, size_t line_length,
+                           int megabytes) {
+    std::string text = MakeText(4 << 20, line_length, delim);
+    Verify(text, delim);
+    const char *d = delim.data();
+    size_t len = delim.size();
+
+    printf("delimiter of %zu bytes, lines of ~%zu bytes:\n", len,
+           line_length);
+    Bench("std::search", text, len, megabytes,
+          [d, len](const char *begin, const char *end) -> const char * {
+              const char *p = std::search(begin, end, d, d + len);
+              return p == end ? nullptr : p;
+          });
+    Bench("memmem", text, len, megabytes,
+          [d, len](const char *begin, const char *end) {
+              return static_cast<const char *>(
+                  ::memmem(begin, end - begin, d, len));
+          });
+    if (len == 1) {
+        Bench("memchr", text, len, megabytes,
+              [d](const char *begin, const char *end) {
+                  return static_cast<const char *>(
+                      ::memchr(begin, *d, end - begin));
+              });
+    }
+    Bench("search::FindDelimiter", text, len, megabytes,
+          [d, len](const char *begin, const char *end) {
+              return search::FindDelimiter(begin, end, d, len);
+          });
+}
+
+// One long line arriving in small reads, searched after each of them.
+static void BenchIncremental(size_t line_length, size_t read_size) {
+    std::string line = MakeText(line_length, line_length * 2, "");
+    line.resize(line_length);
+    line += "\r\n";
+
+    printf("line of %zu bytes arriving in %zu byte reads:\n", line_length,
+           read_size);
+    for (int mode = 0; mode < 3; ++mode) {
+        Buffer buffer;
+        size_t searches = 0;
+        event_loop::MonoTimestamp start = event_loop::MonoTimestamp::Now();
+        for (size_t offset = 0; offset < line.size(); offset += read_size) {
+            buffer.Append(line.data() + offset,
+                          std::min(read_size, line.size() - offset));
+            const char *crlf = nullptr;
+            ++searches;
+            if (mode == 0) {
+                const char *end = buffer.Peek() + buffer.ReadableBytes();
+                crlf = std::search(buffer.Peek(), end, "\r\n", "\r\n" + 2);
+                crlf = crlf == end ? nullptr : crlf;
+            } else if (mode == 1) {
+                crlf = buffer.FindCRLF(buffer.Peek());
+            } else {
+                crlf = buffer.FindCRLF();
+            }
+            if (crlf) {
+                buffer.RetrieveUntil(crlf + 2);
+            }
+        }
+        int64_t elapsed = event_loop::MonoTimestamp::Now() - start;
+        static const char *const kModes[] = {
+            "std::search rescan", "FindCRLF(Peek()) rescan",
+            "FindCRLF() incremental"};
+        printf("  %-24s %9.1f us  (%zu searches)\n", kModes[mode],
+               elapsed / 1e3, searches);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    int megabytes = argc > 1 ? atoi(argv[1]) : 256;
+
+    printf("search kernel: %s\n", search::KernelName());
+    BenchDelimiter("\r\n", 64, megabytes);
+    BenchDelimiter("\r\n", 1024, megabytes);
+    BenchDelimiter("\n", 64, megabytes);
+    BenchDelimiter("\r\n\r\n", 1024, megabytes);
+    BenchDelimiter("--boundary", 4096, megabytes);
+    BenchIncremental(256 * 1024, 1460);
+
+    return 0;
+}
@@ -0,0 +1,182 @@
+// Benchmarks and stress for TimerQueue, through the EventLoop timer API.
+//
+// usage: bench_timer_queue [timers] [burst] [threads]
+//   timers  timers added and cancelled, default 1000000
+//   burst   timers expiring at the same time, default 100000
+//   threads threads calling RunAfter concurrently, default 4
+
+#include "eventloop/event_loop.h"
+#include "eventloop/event_loop_thread.h"
+#include "eventloop/mono_timestamp.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace muduo::event_loop;
+
+static double Millis(int64_t nanoseconds) { return nanoseconds / 1e6; }
+
+static void BenchAddCancel(int timers) {
+    EventLoop loop;
+    std::vector<TimerId> ids;
+    ids.reserve(timers);
+
+    // not looping yet, RunInLoop runs AddTimerInLoop right away
+    MonoTimestamp start = MonoTimestamp::Now();
+    for (int i = 0; i < timers; ++i) {
+        ids.push_back(loop.RunAfter(1000.0 + i * 1e-6, []() {}));
+    }
+    MonoTimestamp added = MonoTimestamp::Now();
+    for (const TimerId &id : ids) {
+        loop.Cancel(id);
+    }
+    MonoTimestamp cancelled = MonoTimestamp::Now();
+
+    printf("add %d timers: %.1f ms, %.0f ns/op\n", timers,
+           Millis(added - start), double(added - start) / timers);
+    printf("cancel %d timers: %.1f ms, %.0f ns/op\n", timers,
+           Millis(cancelled - added), double(cancelled - added) / timers);
+}
+
+static void BenchBurst(int timers, bool repeat) {
+    EventLoop loop;
+    int fired = 0;
+    // every timer expires at the same time, whenever adding them finishes
+    Timestamp wall_deadline = Timestamp::Now() + 0.1;
+    MonoTimestamp deadline = MonoTimestamp::FromTimestamp(wall_deadline);
+    MonoTimestamp first, last, loop_start;
+
+    auto cb = [&]() {
+        if (fired++ == 0) {
+            first = MonoTimestamp::Now();
+        }
+        if (fired == timers) {
+            last = MonoTimestamp::Now();
+            // pending functors run after TimerQueue::HandleRead returns,
+            // i.e. after the repeating timers are re-inserted
+            loop.QueueInLoop([&]() {
+                MonoTimestamp done = MonoTimestamp::Now();
+                // the first callback waits for GetExpired of the whole burst
+                printf("%s burst of %d timers: first callback after %.1f ms, "
+                       "callbacks %.1f ms, expire+reset total %.1f ms\n",
+                       repeat ? "repeating" : "one-shot", timers,
+                       Millis(first - std::max(deadline, loop_start)),
+                       Millis(last - first),
+                       Millis(done - first));
+                loop.Quit();
+            });
+        }
+    };
+
+    for (int i = 0; i < timers; ++i) {
+        if (repeat) {
+            loop.RunEveryAt(1000.0, wall_deadline, cb);
+        } else {
+            loop.RunAt(deadline, cb);
+        }
+    }
+    loop_start = MonoTimestamp::Now();
+    loop.Loop();
+}
+
+static void BenchCrossThread(int threads, int per_thread) {
+    EventLoopThread loop_thread;
+    EventLoop *loop = loop_thread.StartLoop();
+    const int total = threads * per_thread;
+    std::atomic_int fired(0);
+    std::atomic_bool done(false);
+
+    MonoTimestamp start = MonoTimestamp::Now();
+    std::vector<std::thread> producers;
+    for (int t = 0; t < threads; ++t) {
+        producers.emplace_back([&]() {
+            for (int i = 0; i < per_thread; ++i) {
+                loop->RunAfter(std::chrono::nanoseconds(0), [&]() {
+                    if (++fired == total) {
+                        done = true;
+                    }
+                });
+            }
+        });
+    }
+    for (std::thread &t : producers) {
+        t.join();
+    }
+    MonoTimestamp submitted = MonoTimestamp::Now();
+    while (!done) {
+        std::this_thread::yield();
+    }
+    MonoTimestamp finished = MonoTimestamp::Now();
+
+    printf("cross-thread RunAfter, %d threads x %d: submit %.1f ms, "
+           "all fired %.1f ms, %.0f timers/s\n",
+           threads, per_thread, Millis(submitted - start),
+           Millis(finished - start), total / ((finished - start) / 1e9));
+}
+
+static void BenchAccuracy(int timers) {
+    EventLoop loop;
+    // actual minus scheduled, upper bounds in microseconds
+    const int64_t bounds[] = {10, 20, 50, 100, 200, 500, 1000, 5000};
+    const int nbounds = sizeof bounds / sizeof bounds[0];
+    std::vector<int> histogram(nbounds + 1, 0);
+    int64_t worst = 0;
+    int64_t total = 0;
+    int fired = 0;
+
+    std::mt19937 rng(42);
+    // leave room for adding the timers before the first one is due
+    std::uniform_int_distribution<int64_t> delay(
+        100 * kNanoSecondsPerMilliSecond, 600 * kNanoSecondsPerMilliSecond);
+    MonoTimestamp now = MonoTimestamp::Now();
+    for (int i = 0; i < timers; ++i) {
+        MonoTimestamp when = now + delay(rng);
+        loop.RunAt(when, [&, when]() {
+            int64_t late = MonoTimestamp::Now() - when;
+            total += late;
+            if (late > worst) {
+                worst = late;
+            }
+            int b = 0;
+            while (b < nbounds && late > bounds[b] * kNanoSecondsPerMicroSecond) {
+                ++b;
+            }
+            ++histogram[b];
+            if (++fired == timers) {
+                loop.Quit();
+            }
+        });
+    }
+    loop.Loop();
+
+    printf("accuracy of %d timers: mean %.1f us, worst %.1f us\n", timers,
+           total / 1e3 / timers, worst / 1e3);
+    for (int b = 0; b <= nbounds; ++b) {
+        if (b < nbounds) {
+            printf("  <= %5ld us: %d\n", static_cast<long>(bounds[b]),
+                   histogram[b]);
+        } else {
+            printf("   > %5ld us: %d\n", static_cast<long>(bounds[b - 1]),
+                   histogram[b]);
+        }
+    }
+}
+
+int main(int argc, char *argv[]) {
+    int timers = argc > 1 ? atoi(argv[1]) : 1000000;
+    int burst = argc > 2 ? atoi(argv[2]) : 100000;
+    int threads = argc > 3 ? atoi(argv[3]) : 4;
+
+    BenchAddCancel(timers);
+    BenchBurst(burst, false);
+    BenchBurst(burst, true);
+    BenchCrossThread(threads, timers / threads);
+    BenchAccuracy(10000);
+
+    return 0;
+}
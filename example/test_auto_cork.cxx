@@ -0,0 +1,125 @@
+#include "eventloop/eventloop.h"
+#include "logger/logger.h"
+#include "net/buffer.h"
+#include "net/tcp_connection.h"
+#include "net/tcp_server.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <iostream>
+#include <map>
+#include <string>
+#include <thread>
+
+// A client sends requests one at a time, and the server answers each with
+// a status line, a header and a body, sent separately. With auto-cork the
+// three pieces are written together, once per request, which shows as one
+// write complete callback per response instead of three.
+
+using namespace muduo;
+
+namespace {
+
+const int kRequests = 1000;
+const std::string kResponse = "200 OK\r\nLength: 5\r\n\r\nhello";
+
+// @return the number of correct responses
+int RequestResponse(uint16_t port) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    // gives up if the server stalls
+    struct timeval timeout = {5, 0};
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof timeout);
+    struct sockaddr_in addr;
+    ::memset(&addr, 0, sizeof addr);
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    int responses = 0;
+    if (::connect(fd, reinterpret_cast<struct sockaddr *>(&addr),
+                  sizeof addr) == 0) {
+        for (int i = 0; i < kRequests; ++i) {
+            if (::write(fd, "GET\r\n", 5) != 5) {
+                break;
+            }
+            std::string response;
+            char buf[256];
+            ssize_t n;
+            while (response.size() < kResponse.size() &&
+                   (n = ::read(fd, buf, sizeof buf)) > 0) {
+                response.append(buf, n);
+            }
+            if (response != kResponse) {
+                break;
+            }
+            ++responses;
+        }
+    }
+    ::close(fd);
+    return responses;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    uint16_t port = static_cast<uint16_t>(argc > 1 ? atoi(argv[1]) : 23464);
+
+    muduo::log::Logger::set_log_level(muduo::log::Logger::WARN);
+    event_loop::EventLoop loop;
+
+    int connections = 0;
+    // by connection name
+    std::map<std::string, int> write_completes;
+
+    net::TcpServer server(&loop, net::InetAddress(port), "AutoCork");
+    server.set_connection_callback([&](const net::TcpConnectionPtr &conn) {
+        if (conn->Connected()) {
+            conn->SetTcpNoDelay(true);
+            // the first connection corks, the second is for comparison
+            conn->set_auto_cork(++connections == 1);
+        }
+    });
+    server.set_message_callback([](const net::TcpConnectionPtr &conn,
+                                   net::Buffer *buf, event_loop::Timestamp) {
+        muduo::StringPiece request;
+        while (buf->RetrieveCRLFLine(&request)) {
+            conn->Send("200 OK\r\n");
+            conn->Send("Length: 5\r\n\r\n");
+            conn->Send("hello");
+        }
+    });
+    server.set_write_complete_callback(
+        [&](const net::TcpConnectionPtr &conn) {
+            ++write_completes[conn->name()];
+        });
+    server.Start();
+
+    int corked = 0;
+    int uncorked = 0;
+    std::thread client([&]() {
+        corked = RequestResponse(port);
+        uncorked = RequestResponse(port);
+        loop.QueueInLoop([&]() { loop.Quit(); });
+    });
+    loop.Loop();
+    client.join();
+
+    int corked_writes = 0;
+    int uncorked_writes = 0;
+    if (write_completes.size() == 2) {
+        corked_writes = write_completes.begin()->second;
+        uncorked_writes = write_completes.rbegin()->second;
+    }
+    bool ok = corked == kRequests && uncorked == kRequests &&
+              corked_writes == kRequests;
+    std::cout << "responses corked: " << corked << ", not corked: " << uncorked
+              << " of " << kRequests << ", write completes corked: "
+              << corked_writes << ", not corked: " << uncorked_writes
+              << (ok ? " ok" : " FAILED") << std::endl;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,171 @@
+#include "eventloop/eventloop.h"
+#include "logger/logger.h"
+#include "net/buffer.h"
+#include "net/tcp_connection.h"
+#include "net/tcp_server.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <iostream>
+#include <string>
+#include <thread>
+
+// Relays what a fast upstream client sends to a slow downstream client.
+// The downstream connection's water mark callbacks fire as its send buffer
+// fills and drains, and reading from upstream is paused in between, so the
+// relay holds a bounded amount of data however fast upstream sends.
+
+using namespace muduo;
+
+namespace {
+
+const size_t kRelaySize = 32 * 1024 * 1024;
+const size_t kHighWaterMark = 1024 * 1024;
+const size_t kLowWaterMark = 256 * 1024;
+
+std::string Content() {
+    std::string content(kRelaySize, 0);
+    for (size_t i = 0; i < kRelaySize; ++i) {
+        content[i] = static_cast<char>('a' + i % 26);
+    }
+    return content;
+}
+
+int Connect(uint16_t port) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    // gives up if the server stalls
+    struct timeval timeout = {5, 0};
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof timeout);
+    struct sockaddr_in addr;
+    ::memset(&addr, 0, sizeof addr);
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::connect(fd, reinterpret_cast<struct sockaddr *>(&addr),
+                  sizeof addr) < 0) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// reads slowly until the server shuts down
+std::string Downstream(uint16_t port) {
+    std::string received;
+    int fd = Connect(port);
+    char buf[16384];
+    ssize_t n;
+    while ((n = ::read(fd, buf, sizeof buf)) > 0) {
+        received.append(buf, n);
+        ::usleep(100);
+    }
+    ::close(fd);
+    return received;
+}
+
+void Upstream(uint16_t port, const std::string &content) {
+    int fd = Connect(port);
+    size_t written = 0;
+    while (written < content.size()) {
+        ssize_t n = ::write(fd, content.data() + written,
+                            content.size() - written);
+        if (n <= 0) {
+            break;
+        }
+        written += n;
+    }
+    ::shutdown(fd, SHUT_WR);
+    char buf[16];
+    while (::read(fd, buf, sizeof buf) > 0) {
+    }
+    ::close(fd);
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    uint16_t port = static_cast<uint16_t>(argc > 1 ? atoi(argv[1]) : 23463);
+
+    muduo::log::Logger::set_log_level(muduo::log::Logger::WARN);
+    event_loop::EventLoop loop;
+
+    const std::string content = Content();
+    net::TcpConnectionPtr downstream;
+    net::TcpConnectionPtr upstream;
+    int high_marks = 0;
+    int low_marks = 0;
+    bool paused_above_high = true;
+    bool resumed_below_low = true;
+
+    net::TcpServer server(&loop, net::InetAddress(port), "Backpressure");
+    server.set_connection_callback([&](const net::TcpConnectionPtr &conn) {
+        if (conn->Connected() && !downstream) {
+            // the first client is downstream
+            downstream = conn;
+            conn->set_high_water_mark_callback(
+                [&](const net::TcpConnectionPtr &, size_t) {
+                    ++high_marks;
+                    if (upstream) {
+                        paused_above_high &= !upstream->IsReading();
+                    }
+                },
+                kHighWaterMark);
+            conn->set_low_water_mark_callback(
+                [&](const net::TcpConnectionPtr &, size_t) {
+                    ++low_marks;
+                    if (upstream) {
+                        resumed_below_low &= upstream->IsReading();
+                    }
+                },
+                kLowWaterMark);
+        } else if (conn->Connected()) {
+            upstream = conn;
+            downstream->set_backpressure_upstream(upstream);
+        } else if (conn == upstream) {
+            // what is left is sent before the write side is shut down
+            downstream->Shutdown();
+            downstream->set_backpressure_upstream(nullptr);
+            upstream.reset();
+        }
+    });
+    server.set_message_callback([&](const net::TcpConnectionPtr &conn,
+                                    net::Buffer *buf, event_loop::Timestamp) {
+        if (conn == upstream) {
+            // takes the received bytes over without copying them
+            downstream->Send(std::move(*buf));
+        } else {
+            buf->RetrieveAll();
+        }
+    });
+    server.Start();
+
+    std::string received;
+    std::thread clients([&]() {
+        std::thread downstream_client(
+            [&]() { received = Downstream(port); });
+        ::usleep(100 * 1000);
+        Upstream(port, content);
+        downstream_client.join();
+        loop.QueueInLoop([&]() { loop.Quit(); });
+    });
+    loop.Loop();
+    clients.join();
+
+    bool ok = received == content && high_marks > 0 &&
+              low_marks >= high_marks - 1 && paused_above_high &&
+              resumed_below_low;
+    std::cout << "relayed " << received.size() << " of " << content.size()
+              << " bytes in order: " << (received == content)
+              << ", high water marks: " << high_marks
+              << ", low water marks: " << low_marks
+              << ", upstream paused above the high mark: "
+              << paused_above_high << ", resumed below the low mark: "
+              << resumed_below_low << (ok ? " ok" : " FAILED") << std::endl;
+    return ok ? 0 : 1;
+}
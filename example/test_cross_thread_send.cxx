@@ -0,0 +1,147 @@
+#include "eventloop/eventloop.h"
+#include "logger/logger.h"
+#include "net/buffer.h"
+#include "net/tcp_connection.h"
+#include "net/tcp_server.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Several threads send numbered lines on one connection, with each of the
+// Send() overloads in turn, then one of them shuts the connection down. The
+// loop flushes the queued sends in batches, and the client checks that it
+// got every line, each thread's in the order they were sent.
+
+using namespace muduo;
+
+namespace {
+
+const int kThreads = 4;
+const int kLinesPerThread = 20000;
+
+std::string Line(int thread, int seq) {
+    char line[32];
+    snprintf(line, sizeof line, "%d %d\n", thread, seq);
+    return line;
+}
+
+void SendLines(const net::TcpConnectionPtr &conn, int thread) {
+    for (int seq = 0; seq < kLinesPerThread; ++seq) {
+        std::string line = Line(thread, seq);
+        switch (seq % 4) {
+        case 0:
+            conn->Send(line);
+            break;
+        case 1:
+            conn->Send(std::move(line));
+            break;
+        case 2: {
+            net::Buffer buffer;
+            buffer.Append(line.data(), line.size());
+            conn->Send(std::move(buffer));
+            break;
+        }
+        default:
+            conn->Send(net::BufferSlice(std::move(line)));
+            break;
+        }
+    }
+}
+
+std::string ReadUntilClosed(uint16_t port) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    // gives up if the server stalls
+    struct timeval timeout = {5, 0};
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof timeout);
+    struct sockaddr_in addr;
+    ::memset(&addr, 0, sizeof addr);
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    std::string received;
+    if (::connect(fd, reinterpret_cast<struct sockaddr *>(&addr),
+                  sizeof addr) == 0) {
+        char buf[16384];
+        ssize_t n;
+        while ((n = ::read(fd, buf, sizeof buf)) > 0) {
+            received.append(buf, n);
+        }
+    }
+    ::close(fd);
+    return received;
+}
+
+// @return the number of lines, or -1 if a thread's lines are out of order
+int CheckLines(const std::string &received) {
+    std::vector<int> next(kThreads, 0);
+    std::istringstream lines(received);
+    int thread, seq, count = 0;
+    while (lines >> thread >> seq) {
+        if (thread < 0 || thread >= kThreads || seq != next[thread]) {
+            return -1;
+        }
+        ++next[thread];
+        ++count;
+    }
+    return count;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    uint16_t port = static_cast<uint16_t>(argc > 1 ? atoi(argv[1]) : 23462);
+
+    muduo::log::Logger::set_log_level(muduo::log::Logger::WARN);
+    event_loop::EventLoop loop;
+
+    std::vector<std::thread> senders;
+    net::TcpServer server(&loop, net::InetAddress(port), "CrossThreadSend");
+    server.set_connection_callback([&](const net::TcpConnectionPtr &conn) {
+        if (!conn->Connected()) {
+            return;
+        }
+        std::thread sender([conn]() {
+            std::vector<std::thread> threads;
+            for (int i = 0; i < kThreads; ++i) {
+                threads.emplace_back(SendLines, conn, i);
+            }
+            for (std::thread &thread : threads) {
+                thread.join();
+            }
+            // right after the last sends, which may not be flushed yet
+            conn->Shutdown();
+        });
+        senders.push_back(std::move(sender));
+    });
+    server.Start();
+
+    std::string received;
+    std::thread client([&]() {
+        received = ReadUntilClosed(port);
+        loop.QueueInLoop([&]() { loop.Quit(); });
+    });
+    loop.Loop();
+    client.join();
+    for (std::thread &sender : senders) {
+        sender.join();
+    }
+
+    int lines = CheckLines(received);
+    bool ok = lines == kThreads * kLinesPerThread;
+    std::cout << "received " << lines << " of " << kThreads * kLinesPerThread
+              << " lines" << (lines < 0 ? " out of order" : "")
+              << (ok ? " ok" : " FAILED") << std::endl;
+    return ok ? 0 : 1;
+}
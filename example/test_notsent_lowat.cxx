@@ -0,0 +1,120 @@
+#include "eventloop/eventloop.h"
+#include "logger/logger.h"
+#include "net/tcp_connection.h"
+#include "net/tcp_server.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <string>
+#include <thread>
+
+// Streams chunks to a slow client, producing the next one from the write
+// complete callback. With TCP_NOTSENT_LOWAT the callback waits until the
+// kernel has little left to send, so the producer stays just ahead of the
+// client instead of filling the socket buffers.
+
+using namespace muduo;
+
+namespace {
+
+const size_t kChunkSize = 64 * 1024;
+const int kChunks = 256;
+const size_t kNotSentLowat = 64 * 1024;
+// unsent bytes, the client's receive window and one chunk, with room
+const size_t kMaxAhead = 1024 * 1024;
+
+std::string Chunk(int seq) {
+    return std::string(kChunkSize, static_cast<char>('a' + seq % 26));
+}
+
+// reads slowly until the server shuts down
+std::string SlowClient(uint16_t port, std::atomic<size_t> *received_bytes) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    int rcvbuf = 64 * 1024;
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof rcvbuf);
+    // gives up if the server stalls
+    struct timeval timeout = {5, 0};
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof timeout);
+    struct sockaddr_in addr;
+    ::memset(&addr, 0, sizeof addr);
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    std::string received;
+    if (::connect(fd, reinterpret_cast<struct sockaddr *>(&addr),
+                  sizeof addr) == 0) {
+        char buf[16384];
+        ssize_t n;
+        while ((n = ::read(fd, buf, sizeof buf)) > 0) {
+            received.append(buf, n);
+            *received_bytes = received.size();
+            ::usleep(500);
+        }
+    }
+    ::close(fd);
+    return received;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    uint16_t port = static_cast<uint16_t>(argc > 1 ? atoi(argv[1]) : 23467);
+
+    muduo::log::Logger::set_log_level(muduo::log::Logger::WARN);
+    event_loop::EventLoop loop;
+
+    std::atomic<size_t> received_bytes(0);
+    bool supported = false;
+    int produced = 0;
+    size_t max_ahead = 0;
+
+    net::TcpServer server(&loop, net::InetAddress(port), "NotSentLowat");
+    server.set_connection_callback([&](const net::TcpConnectionPtr &conn) {
+        if (conn->Connected()) {
+            supported = conn->SetTcpNotSentLowat(kNotSentLowat);
+            conn->Send(Chunk(produced++));
+        }
+    });
+    server.set_write_complete_callback(
+        [&](const net::TcpConnectionPtr &conn) {
+            // how far the producer is ahead of what the client has read
+            max_ahead = std::max(max_ahead, produced * kChunkSize -
+                                                received_bytes.load());
+            if (produced < kChunks) {
+                conn->Send(Chunk(produced++));
+            } else {
+                conn->Shutdown();
+            }
+        });
+    server.Start();
+
+    std::string received;
+    std::thread client([&]() {
+        received = SlowClient(port, &received_bytes);
+        loop.QueueInLoop([&]() { loop.Quit(); });
+    });
+    loop.Loop();
+    client.join();
+
+    std::string expected;
+    for (int i = 0; i < kChunks; ++i) {
+        expected += Chunk(i);
+    }
+    bool ok = received == expected && (!supported || max_ahead <= kMaxAhead);
+    std::cout << "TCP_NOTSENT_LOWAT: " << supported << ", received "
+              << received.size() << " of " << expected.size()
+              << " bytes in order: " << (received == expected)
+              << ", producer at most " << max_ahead
+              << " bytes ahead of the client" << (ok ? " ok" : " FAILED")
+              << std::endl;
+    return ok ? 0 : 1;
+}
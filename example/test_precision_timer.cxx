@@ -0,0 +1,35 @@
+#include "eventloop/event_loop.h"
+#include "eventloop/precision_timer.h"
+
+#include <iostream>
+
+using namespace muduo::event_loop;
+
+int main() {
+    EventLoop loop;
+
+    int ticks = 0;
+    PrecisionTimer pacer(&loop, [&]() {
+        if (++ticks == 2000) {
+            loop.Quit();
+        }
+    });
+
+    // plain timer on the same loop for comparison
+    Timestamp expected = Timestamp::Now() + 0.5;
+    loop.RunAt(expected, [=]() {
+        std::cout << "ordinary timer jitter "
+                  << (Timestamp::Now() - expected) * 1e6 << "us" << std::endl;
+    });
+
+    // pace every 500us for one second
+    pacer.set_spin_threshold(100 * kNanoSecondsPerMicroSecond);
+    pacer.Start(MonoTimestamp::Now() + kNanoSecondsPerMilliSecond,
+                500 * kNanoSecondsPerMicroSecond);
+
+    loop.Loop();
+
+    std::cout << "precision timer " << pacer.stats().ToString() << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,146 @@
+#include "eventloop/eventloop.h"
+#include "logger/logger.h"
+#include "net/buffer.h"
+#include "net/tcp_connection.h"
+#include "net/tcp_server.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <thread>
+
+// A bulk client uploads as fast as it can while another client plays
+// ping-pong on the same loop. With a read budget, each readable event of
+// the bulk connection reads at most that much, and the pings are answered
+// in between.
+
+using namespace muduo;
+
+namespace {
+
+const size_t kUploadSize = 64 * 1024 * 1024;
+const size_t kReadBudget = 64 * 1024;
+const int kPings = 200;
+
+int Connect(uint16_t port) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    // gives up if the server stalls
+    struct timeval timeout = {5, 0};
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof timeout);
+    struct sockaddr_in addr;
+    ::memset(&addr, 0, sizeof addr);
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::connect(fd, reinterpret_cast<struct sockaddr *>(&addr),
+                  sizeof addr) < 0) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+void Upload(int fd) {
+    std::string chunk(256 * 1024, 'x');
+    size_t written = 0;
+    while (written < kUploadSize) {
+        ssize_t n = ::write(fd, chunk.data(), chunk.size());
+        if (n <= 0) {
+            break;
+        }
+        written += n;
+    }
+    ::shutdown(fd, SHUT_WR);
+    char buf[16];
+    while (::read(fd, buf, sizeof buf) > 0) {
+    }
+    ::close(fd);
+}
+
+// @return the number of pings answered
+int PingPong(int fd, double *max_rtt) {
+    int pongs = 0;
+    for (int i = 0; i < kPings; ++i) {
+        event_loop::Timestamp start = event_loop::Timestamp::Now();
+        if (::write(fd, "ping\r\n", 6) != 6) {
+            break;
+        }
+        std::string pong;
+        char buf[16];
+        ssize_t n;
+        while (pong.size() < 6 && (n = ::read(fd, buf, sizeof buf)) > 0) {
+            pong.append(buf, n);
+        }
+        if (pong != "pong\r\n") {
+            break;
+        }
+        *max_rtt = std::max(*max_rtt, event_loop::Timestamp::Now() - start);
+        ++pongs;
+    }
+    ::close(fd);
+    return pongs;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    uint16_t port = static_cast<uint16_t>(argc > 1 ? atoi(argv[1]) : 23469);
+
+    muduo::log::Logger::set_log_level(muduo::log::Logger::WARN);
+    event_loop::EventLoop loop;
+
+    size_t uploaded = 0;
+    size_t max_read = 0;
+
+    net::TcpServer server(&loop, net::InetAddress(port), "ReadBudget");
+    server.set_connection_callback([](const net::TcpConnectionPtr &conn) {
+        if (conn->Connected()) {
+            conn->set_read_budget(kReadBudget);
+        }
+    });
+    server.set_message_callback([&](const net::TcpConnectionPtr &conn,
+                                    net::Buffer *buf, event_loop::Timestamp) {
+        if (buf->Peek()[0] == 'x') {
+            // everything is consumed, so this is what one event read
+            max_read = std::max(max_read, buf->ReadableBytes());
+            uploaded += buf->ReadableBytes();
+            buf->RetrieveAll();
+            return;
+        }
+        muduo::StringPiece ping;
+        while (buf->RetrieveCRLFLine(&ping)) {
+            conn->Send("pong\r\n");
+        }
+    });
+    server.Start();
+
+    int pongs = 0;
+    double max_rtt = 0;
+    std::thread clients([&]() {
+        int bulk = Connect(port);
+        int ping = Connect(port);
+        std::thread upload(Upload, bulk);
+        pongs = PingPong(ping, &max_rtt);
+        upload.join();
+        loop.QueueInLoop([&]() { loop.Quit(); });
+    });
+    loop.Loop();
+    clients.join();
+
+    bool ok = uploaded == kUploadSize && max_read <= kReadBudget &&
+              pongs == kPings;
+    std::cout << "uploaded " << uploaded << " of " << kUploadSize
+              << " bytes, at most " << max_read << " per read, pings answered "
+              << pongs << " of " << kPings << ", slowest in "
+              << max_rtt * 1e6 << "us" << (ok ? " ok" : " FAILED")
+              << std::endl;
+    return ok ? 0 : 1;
+}
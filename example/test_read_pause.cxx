@@ -0,0 +1,136 @@
+#include "eventloop/eventloop.h"
+#include "logger/logger.h"
+#include "net/buffer.h"
+#include "net/tcp_connection.h"
+#include "net/tcp_server.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <thread>
+
+// A client uploads as fast as it can. The server stops reading as the
+// connection is established and starts again a while later, then lets the
+// receive buffer fill up to its cap before consuming it from a timer and
+// resuming. Reading must stay paused while stopped or at the cap, the
+// buffer never grows past the cap, and every byte arrives.
+
+using namespace muduo;
+
+namespace {
+
+const size_t kUploadSize = 8 * 1024 * 1024;
+const size_t kReceiveBufferCap = 1024 * 1024;
+const double kStopSeconds = 0.2;
+
+std::string Content() {
+    std::string content(kUploadSize, 0);
+    for (size_t i = 0; i < kUploadSize; ++i) {
+        content[i] = static_cast<char>('a' + i % 26);
+    }
+    return content;
+}
+
+void Upload(uint16_t port, const std::string &content) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    // gives up if the server stalls
+    struct timeval timeout = {5, 0};
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof timeout);
+    ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof timeout);
+    struct sockaddr_in addr;
+    ::memset(&addr, 0, sizeof addr);
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::connect(fd, reinterpret_cast<struct sockaddr *>(&addr),
+                  sizeof addr) == 0) {
+        size_t written = 0;
+        ssize_t n;
+        while (written < content.size() &&
+               (n = ::write(fd, content.data() + written,
+                            content.size() - written)) > 0) {
+            written += n;
+        }
+        ::shutdown(fd, SHUT_WR);
+        char buf[16];
+        while (::read(fd, buf, sizeof buf) > 0) {
+        }
+    }
+    ::close(fd);
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    uint16_t port = static_cast<uint16_t>(argc > 1 ? atoi(argv[1]) : 23466);
+
+    muduo::log::Logger::set_log_level(muduo::log::Logger::WARN);
+    event_loop::EventLoop loop;
+
+    const std::string content = Content();
+    std::string received;
+    bool started = false;
+    int reads_while_stopped = 0;
+    size_t max_buffered = 0;
+    int cap_pauses = 0;
+    bool paused_at_cap = true;
+
+    net::TcpServer server(&loop, net::InetAddress(port), "ReadPause");
+    server.set_connection_callback([&](const net::TcpConnectionPtr &conn) {
+        if (conn->Connected()) {
+            conn->set_receive_buffer_cap(kReceiveBufferCap);
+            conn->StopRead();
+            loop.RunAfter(kStopSeconds, [&started, conn]() {
+                started = true;
+                conn->StartRead();
+            });
+        }
+    });
+    server.set_message_callback([&](const net::TcpConnectionPtr &conn,
+                                    net::Buffer *buf, event_loop::Timestamp) {
+        if (!started) {
+            ++reads_while_stopped;
+        }
+        max_buffered = std::max(max_buffered, buf->ReadableBytes());
+        if (buf->ReadableBytes() < kReceiveBufferCap) {
+            // leave it, reading stops once the buffer reaches the cap
+            return;
+        }
+        ++cap_pauses;
+        // consumed later, as by a slow worker, then reading resumes
+        loop.RunAfter(0.01, [&, conn, buf]() {
+            paused_at_cap &= !conn->IsReading();
+            received += buf->RetrieveAllAsString();
+            conn->StartRead();
+        });
+    });
+    server.Start();
+
+    std::thread client([&]() {
+        Upload(port, content);
+        loop.QueueInLoop([&]() { loop.Quit(); });
+    });
+    loop.Loop();
+    client.join();
+
+    bool ok = received == content && reads_while_stopped == 0 &&
+              max_buffered <= kReceiveBufferCap &&
+              cap_pauses == static_cast<int>(kUploadSize / kReceiveBufferCap) &&
+              paused_at_cap;
+    std::cout << "received " << received.size() << " of " << content.size()
+              << " bytes in order: " << (received == content)
+              << ", reads while stopped: " << reads_while_stopped
+              << ", most buffered: " << max_buffered << " of "
+              << kReceiveBufferCap << ", pauses at the cap: " << cap_pauses
+              << ", paused until resumed: " << paused_at_cap
+              << (ok ? " ok" : " FAILED") << std::endl;
+    return ok ? 0 : 1;
+}
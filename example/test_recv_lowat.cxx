@@ -0,0 +1,140 @@
+#include "eventloop/eventloop.h"
+#include "logger/logger.h"
+#include "net/buffer.h"
+#include "net/tcp_connection.h"
+#include "net/tcp_server.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <iostream>
+#include <map>
+#include <string>
+#include <thread>
+
+// A client sends large length-prefixed frames, each in many small writes.
+// The server's codec tells the connection how many bytes the frame still
+// misses with NeedMoreBytes(), so with SO_RCVLOWAT the loop wakes up once
+// a frame is nearly whole, not for every write. A second connection, whose
+// codec does not, is for comparison.
+
+using namespace muduo;
+
+namespace {
+
+const int kFrames = 32;
+const size_t kFrameSize = 256 * 1024;
+const size_t kPieceSize = 16 * 1024;
+// the first piece and the rest of the frame, with room
+const double kMaxCallbacksPerFrame = 4;
+
+struct CodecStats {
+    int frames = 0;
+    int bad_frames = 0;
+    int callbacks = 0;
+};
+
+void SendFrames(uint16_t port) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr;
+    ::memset(&addr, 0, sizeof addr);
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::connect(fd, reinterpret_cast<struct sockaddr *>(&addr),
+                  sizeof addr) == 0) {
+        for (int i = 0; i < kFrames; ++i) {
+            net::Buffer frame;
+            std::string body(kFrameSize, static_cast<char>('a' + i % 26));
+            frame.AppendInt32(static_cast<int32_t>(body.size()));
+            frame.Append(body.data(), body.size());
+            while (frame.ReadableBytes() > 0) {
+                size_t n = std::min(frame.ReadableBytes(), kPieceSize);
+                if (::write(fd, frame.Peek(), n) != static_cast<ssize_t>(n)) {
+                    break;
+                }
+                frame.Retrieve(n);
+                ::usleep(200);
+            }
+        }
+        ::shutdown(fd, SHUT_WR);
+        char buf[16];
+        while (::read(fd, buf, sizeof buf) > 0) {
+        }
+    }
+    ::close(fd);
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    uint16_t port = static_cast<uint16_t>(argc > 1 ? atoi(argv[1]) : 23468);
+
+    muduo::log::Logger::set_log_level(muduo::log::Logger::WARN);
+    event_loop::EventLoop loop;
+
+    // by connection name, the first connection asks for whole frames
+    std::map<std::string, CodecStats> stats;
+    std::string first;
+
+    net::TcpServer server(&loop, net::InetAddress(port), "RecvLowat");
+    server.set_connection_callback([&](const net::TcpConnectionPtr &conn) {
+        if (conn->Connected() && first.empty()) {
+            first = conn->name();
+        }
+    });
+    server.set_message_callback([&](const net::TcpConnectionPtr &conn,
+                                    net::Buffer *buf, event_loop::Timestamp) {
+        CodecStats &codec = stats[conn->name()];
+        ++codec.callbacks;
+        while (buf->ReadableBytes() >= sizeof(int32_t)) {
+            const size_t frame_size =
+                sizeof(int32_t) + static_cast<size_t>(buf->PeekInt32());
+            if (buf->ReadableBytes() < frame_size) {
+                if (conn->name() == first) {
+                    conn->NeedMoreBytes(frame_size - buf->ReadableBytes());
+                }
+                break;
+            }
+            buf->Retrieve(sizeof(int32_t));
+            std::string body = buf->RetrieveAsString(frame_size -
+                                                     sizeof(int32_t));
+            const char expected = static_cast<char>('a' + codec.frames % 26);
+            if (body != std::string(kFrameSize, expected)) {
+                ++codec.bad_frames;
+            }
+            ++codec.frames;
+        }
+    });
+    server.Start();
+
+    std::thread client([&]() {
+        SendFrames(port);
+        SendFrames(port);
+        loop.QueueInLoop([&]() { loop.Quit(); });
+    });
+    loop.Loop();
+    client.join();
+
+    CodecStats lowat;
+    CodecStats plain;
+    for (const auto &it : stats) {
+        (it.first == first ? lowat : plain) = it.second;
+    }
+    const double lowat_per_frame = 1.0 * lowat.callbacks / kFrames;
+    const double plain_per_frame = 1.0 * plain.callbacks / kFrames;
+    bool ok = lowat.frames == kFrames && plain.frames == kFrames &&
+              lowat.bad_frames == 0 && plain.bad_frames == 0 &&
+              lowat_per_frame <= kMaxCallbacksPerFrame;
+    std::cout << "frames " << lowat.frames << " and " << plain.frames << " of "
+              << kFrames << ", message callbacks per frame with "
+              << "NeedMoreBytes(): " << lowat_per_frame
+              << ", without: " << plain_per_frame << (ok ? " ok" : " FAILED")
+              << std::endl;
+    return ok ? 0 : 1;
+}
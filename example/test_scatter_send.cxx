@@ -0,0 +1,129 @@
+#include "eventloop/eventloop.h"
+#include "logger/logger.h"
+#include "net/tcp_connection.h"
+#include "net/tcp_server.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Sends one message of more fragments than writev(2) takes from the loop
+// thread, and another from a second thread, to a client that reads slowly.
+// The fragments are freed right after Send(), so the unsent tail must have
+// been copied, and the client checks it got both messages in order.
+
+using namespace muduo;
+
+namespace {
+
+const int kFragments = 3000;
+
+// fragments of varying size, some large enough to fill the socket
+std::vector<std::string> MakeFragments(char tag) {
+    std::vector<std::string> fragments;
+    for (int i = 0; i < kFragments; ++i) {
+        char header[32];
+        snprintf(header, sizeof header, "%c%d:", tag, i);
+        size_t size = i % 100 == 0 ? 256 * 1024 : i % 7 * 10;
+        fragments.push_back(header + std::string(size, tag));
+    }
+    return fragments;
+}
+
+std::string Join(const std::vector<std::string> &fragments) {
+    std::string message;
+    for (const std::string &fragment : fragments) {
+        message += fragment;
+    }
+    return message;
+}
+
+// reads until the server shuts down, after sleeping a while
+std::string SlowClient(uint16_t port) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    int rcvbuf = 4096;
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof rcvbuf);
+    // gives up if the server stalls
+    struct timeval timeout = {5, 0};
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof timeout);
+    struct sockaddr_in addr;
+    ::memset(&addr, 0, sizeof addr);
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    std::string received;
+    if (::connect(fd, reinterpret_cast<struct sockaddr *>(&addr),
+                  sizeof addr) == 0) {
+        ::usleep(200 * 1000);
+        char buf[16384];
+        ssize_t n;
+        while ((n = ::read(fd, buf, sizeof buf)) > 0) {
+            received.append(buf, n);
+        }
+    }
+    ::close(fd);
+    return received;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    uint16_t port = static_cast<uint16_t>(argc > 1 ? atoi(argv[1]) : 23465);
+
+    muduo::log::Logger::set_log_level(muduo::log::Logger::WARN);
+    event_loop::EventLoop loop;
+
+    const std::string expected =
+        Join(MakeFragments('a')) + Join(MakeFragments('b'));
+
+    std::thread sender;
+    net::TcpServer server(&loop, net::InetAddress(port), "ScatterSend");
+    server.set_connection_callback([&](const net::TcpConnectionPtr &conn) {
+        if (!conn->Connected()) {
+            return;
+        }
+        {
+            std::vector<std::string> fragments = MakeFragments('a');
+            std::vector<struct iovec> vec(fragments.size());
+            for (size_t i = 0; i < fragments.size(); ++i) {
+                vec[i].iov_base = &fragments[i][0];
+                vec[i].iov_len = fragments[i].size();
+            }
+            conn->Send(vec.data(), static_cast<int>(vec.size()));
+        }
+        sender = std::thread([conn]() {
+            std::vector<std::string> fragments = MakeFragments('b');
+            std::vector<muduo::StringPiece> pieces(fragments.begin(),
+                                                   fragments.end());
+            conn->Send(pieces.data(), static_cast<int>(pieces.size()));
+            conn->Shutdown();
+        });
+    });
+    server.Start();
+
+    std::string received;
+    std::thread client([&]() {
+        received = SlowClient(port);
+        loop.QueueInLoop([&]() { loop.Quit(); });
+    });
+    loop.Loop();
+    client.join();
+    sender.join();
+
+    bool ok = received == expected;
+    std::cout << "received " << received.size() << " of " << expected.size()
+              << " bytes in order: " << ok << (ok ? " ok" : " FAILED")
+              << std::endl;
+    return ok ? 0 : 1;
+}
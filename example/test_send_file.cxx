@@ -0,0 +1,142 @@
+#include "eventloop/eventloop.h"
+#include "logger/logger.h"
+#include "net/tcp_connection.h"
+#include "net/tcp_server.h"
+
+#include <arpa/inet.h>
+#include <dirent.h>
+#include <netinet/in.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <iostream>
+#include <string>
+#include <thread>
+
+// Sends a header, a file, a slice and a trailer, in this order, to a client
+// that reads slowly. The header fills the socket and is queued, and the file
+// is only sent once the header has drained, behind the emptied send buffer.
+
+using namespace muduo;
+
+namespace {
+
+// more than the socket buffers take, and not a multiple of the slab size,
+// so the last slab of the header is left half full
+const size_t kHeaderSize = 16 * 1024 * 1024 + 1000;
+const size_t kFileSize = 4 * 1024 * 1024;
+const size_t kSliceSize = 256 * 1024;
+const std::string kTrailer = "end";
+
+int CountOpenFds() {
+    int count = 0;
+    DIR *dir = ::opendir("/proc/self/fd");
+    while (::readdir(dir)) {
+        ++count;
+    }
+    ::closedir(dir);
+    return count;
+}
+
+std::string FileContent() {
+    std::string content(kFileSize, 0);
+    for (size_t i = 0; i < kFileSize; ++i) {
+        content[i] = static_cast<char>('a' + i % 26);
+    }
+    return content;
+}
+
+// reads until the server shuts down, after sleeping a while
+std::string SlowClient(uint16_t port) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    int rcvbuf = 4096;
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof rcvbuf);
+    // gives up if the server stalls
+    struct timeval timeout = {5, 0};
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof timeout);
+    struct sockaddr_in addr;
+    ::memset(&addr, 0, sizeof addr);
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    std::string received;
+    if (::connect(fd, reinterpret_cast<struct sockaddr *>(&addr),
+                  sizeof addr) == 0) {
+        ::usleep(200 * 1000);
+        char buf[16384];
+        ssize_t n;
+        while ((n = ::read(fd, buf, sizeof buf)) > 0) {
+            received.append(buf, n);
+        }
+    }
+    ::close(fd);
+    return received;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    uint16_t port = static_cast<uint16_t>(argc > 1 ? atoi(argv[1]) : 23460);
+
+    muduo::log::Logger::set_log_level(muduo::log::Logger::WARN);
+    event_loop::EventLoop loop;
+
+    const std::string file_content = FileContent();
+    char path[] = "/tmp/test_send_file_XXXXXX";
+    int file_fd = ::mkstemp(path);
+    ::unlink(path);
+    if (file_fd < 0 || ::write(file_fd, file_content.data(), kFileSize) !=
+                           static_cast<ssize_t>(kFileSize)) {
+        std::cout << "cannot write " << path << std::endl;
+        return 1;
+    }
+
+    // copied into the send buffer, the rvalue overload would queue a slice
+    const std::string header(kHeaderSize, 'h');
+    int write_completes = 0;
+    int fds_queued = 0;
+    bool file_closed = false;
+
+    net::TcpServer server(&loop, net::InetAddress(port), "SendFile");
+    server.set_connection_callback([&](const net::TcpConnectionPtr &conn) {
+        if (conn->Connected()) {
+            conn->Send(header);
+        }
+    });
+    server.set_write_complete_callback([&](const net::TcpConnectionPtr &conn) {
+        if (++write_completes == 1) {
+            // the header has drained
+            conn->SendFile(file_fd, 0, kFileSize);
+            conn->Send(net::BufferSlice(std::string(kSliceSize, 's')));
+            conn->Send(kTrailer);
+            // the file range holds a duplicate of file_fd until it is sent
+            fds_queued = CountOpenFds();
+        } else {
+            file_closed = CountOpenFds() == fds_queued - 1;
+            conn->Shutdown();
+        }
+    });
+    server.Start();
+
+    std::string received;
+    std::thread client([&]() {
+        received = SlowClient(port);
+        loop.QueueInLoop([&]() { loop.Quit(); });
+    });
+    loop.Loop();
+    client.join();
+    ::close(file_fd);
+
+    const std::string expected =
+        header + file_content + std::string(kSliceSize, 's') + kTrailer;
+    bool ok = received == expected && write_completes == 2 && file_closed;
+    std::cout << "received " << received.size() << " of " << expected.size()
+              << " bytes in order: " << (received == expected)
+              << ", write completes: " << write_completes
+              << ", file range done before the last: " << file_closed
+              << (ok ? " ok" : " FAILED") << std::endl;
+    return ok ? 0 : 1;
+}
@@ -25,6 +25,14 @@ int main() {
                   << std::endl;
     });
 
+    // run after, std::chrono duration
+    loop.RunAfter(std::chrono::milliseconds(6500), []() {
+        std::cout << "timer 6, run after 6500ms, "
+                  << muduo::event_loop::Timestamp::Now()
+                         .ToFormattedMicroSecondsString()
+                  << std::endl;
+    });
+
     // run every
     loop.RunEvery(7, []() {
         std::cout << "timer 3, run every 7s, "
@@ -49,6 +57,22 @@ int main() {
                   << std::endl;
     });
 
+    // run every with slack, the average period must stay at the interval
+    // even though each firing may be up to the slack late
+    auto slack_start = muduo::event_loop::Timestamp::Now();
+    int slack_count = 0;
+    auto slack_timer = loop.RunEvery(0.1, [&slack_count]() { ++slack_count; },
+                                     0.05);
+    loop.RunAfter(2.05, [&]() {
+        loop.Cancel(slack_timer);
+        double elapsed =
+            muduo::event_loop::Timestamp::Now() - slack_start;
+        double period = elapsed / slack_count;
+        std::cout << "timer 7, run every 0.1s with 0.05s slack, fired "
+                  << slack_count << " times, average period " << period
+                  << (period < 0.11 ? " ok" : " FAILED") << std::endl;
+    });
+
     loop.Loop();
 
     return 0;
@@ -28,6 +28,8 @@ __thread int t_cached_tid = 0;
 __thread char t_tid_str[32] = {0};
 __thread int t_tid_str_length = 0;
 
+__thread const int64_t *t_cached_clock = nullptr;
+
 void CacheTid() {
     if (t_cached_tid == 0) {
         t_cached_tid = static_cast<pid_t>(::syscall(SYS_gettid));
@@ -82,6 +84,10 @@ Logger::FlushFunc g_flush = DefaultFlush;
 void Logger::SetOutput(OutputFunc func) { g_output = func; }
 void Logger::SetFlush(FlushFunc func) { g_flush = func; }
 
+void Logger::SetThreadCachedClock(const int64_t *micro_ts) {
+    localthread::t_cached_clock = micro_ts;
+}
+
 /**
  * @brief 全局日志等级设置
  *
@@ -128,7 +134,8 @@ inline LogStream &operator<<(LogStream &s, const Logger::SourceFile &v) {
 
 Logger::Impl::Impl(LogLevel level, int old_errno, const SourceFile &file,
                    int line)
-    : micro_ts_(timestamp_microseconds_now()),
+    : micro_ts_(localthread::t_cached_clock ? *localthread::t_cached_clock
+                                            : timestamp_microseconds_now()),
       level_(level),
       line_(line),
       basename_(file) {
@@ -72,6 +72,11 @@ public:
     static void SetOutput(OutputFunc); // 设置日志输出位置
     static void SetFlush(FlushFunc);
 
+    /// 本线程的日志使用调用者维护的时间（自epoch起的微秒数），
+    /// 比如事件循环每轮更新一次的时钟，避免每条日志都读取系统时钟。
+    /// nullptr恢复读取系统时钟。
+    static void SetThreadCachedClock(const int64_t *micro_ts);
+
 private:
     // 内部类
     class Impl {
@@ -2,39 +2,311 @@
 #include "inet_socket.h"
 
 #include <errno.h>
+#include <sys/mman.h>
 #include <sys/socket.h>
 #include <sys/uio.h>
+#include <unistd.h>
 
 #include <iostream>
+#include <new>
 
 namespace muduo {
 namespace net {
 
-const char Buffer::kCRLF[] = "\r\n";
+const size_t Buffer::kMinReadHint;
+const size_t Buffer::kMaxReadHint;
+char Buffer::empty_storage_[kCheapPrepend];
 
-ssize_t Buffer::ReadFd(int fd, int *saved_errno) {
+Buffer::Buffer(size_t initial_size)
+    : buffer_(nullptr),
+      capacity_(0),
+      reader_index_(kCheapPrepend),
+      writer_index_(kCheapPrepend),
+      read_hint_(0),
+      crlf_scanned_(0),
+      ring_size_(0) {
+    Reallocate(kCheapPrepend + initial_size);
+}
+
+Buffer::Buffer(size_t prepend_size, size_t initial_size)
+    : buffer_(nullptr),
+      capacity_(0),
+      reader_index_(prepend_size),
+      writer_index_(prepend_size),
+      read_hint_(0),
+      crlf_scanned_(0),
+      ring_size_(0) {
+    assert(prepend_size >= 10);
+    Reallocate(prepend_size + initial_size);
+}
+
+Buffer::Buffer(std::shared_ptr<event_loop::MemoryPool> pool,
+               size_t initial_size)
+    : pool_(std::move(pool)),
+      buffer_(nullptr),
+      capacity_(0),
+      reader_index_(kCheapPrepend),
+      writer_index_(kCheapPrepend),
+      read_hint_(0),
+      crlf_scanned_(0),
+      ring_size_(0) {
+    Reallocate(kCheapPrepend + initial_size);
+}
+
+Buffer::Buffer(const Buffer &rhs)
+    : pool_(rhs.pool_),
+      buffer_(nullptr),
+      capacity_(0),
+      reader_index_(rhs.reader_index_),
+      writer_index_(rhs.writer_index_),
+      read_hint_(rhs.read_hint_),
+      crlf_scanned_(rhs.crlf_scanned_),
+      ring_size_(0) {
+    Reallocate(rhs.capacity_);
+    std::copy(rhs.Peek(), rhs.BeginWrite(), begin() + reader_index_);
+}
+
+Buffer::Buffer(Buffer &&rhs)
+    : pool_(std::move(rhs.pool_)),
+      buffer_(rhs.buffer_),
+      capacity_(rhs.capacity_),
+      reader_index_(rhs.reader_index_),
+      writer_index_(rhs.writer_index_),
+      read_hint_(rhs.read_hint_),
+      crlf_scanned_(rhs.crlf_scanned_),
+      shared_block_(std::move(rhs.shared_block_)),
+      ring_size_(rhs.ring_size_) {
+    rhs.ring_size_ = 0;
+    rhs.buffer_ = empty_storage_;
+    rhs.capacity_ = kCheapPrepend;
+    rhs.reader_index_ = kCheapPrepend;
+    rhs.writer_index_ = kCheapPrepend;
+    rhs.crlf_scanned_ = 0;
+}
+
+Buffer &Buffer::operator=(Buffer rhs) {
+    swap(rhs);
+    return *this;
+}
+
+Buffer::~Buffer() { FreeStorage(); }
+
+void Buffer::swap(Buffer &rhs) {
+    pool_.swap(rhs.pool_);
+    std::swap(buffer_, rhs.buffer_);
+    std::swap(capacity_, rhs.capacity_);
+    std::swap(reader_index_, rhs.reader_index_);
+    std::swap(writer_index_, rhs.writer_index_);
+    std::swap(read_hint_, rhs.read_hint_);
+    std::swap(crlf_scanned_, rhs.crlf_scanned_);
+    shared_block_.swap(rhs.shared_block_);
+    std::swap(ring_size_, rhs.ring_size_);
+}
+
+void Buffer::Reallocate(size_t size) {
+    char *block = nullptr;
+    size_t capacity = size;
+    if (pool_) {
+        block = pool_->Allocate(size, &capacity);
+    } else {
+        block = static_cast<char *>(::malloc(size));
+    }
+    if (!block) {
+        throw std::bad_alloc();
+    }
+
+    if (buffer_) {
+        // only readable bytes move, to the front of the new block
+        size_t readable = ReadableBytes();
+        std::copy(Peek(), static_cast<const char *>(BeginWrite()),
+                  block + kCheapPrepend);
+        reader_index_ = kCheapPrepend;
+        writer_index_ = reader_index_ + readable;
+        FreeStorage();
+    }
+    buffer_ = block;
+    capacity_ = capacity;
+}
+
+void Buffer::FreeStorage() {
+    if (shared_block_) {
+        // the last of this buffer and its slices frees it
+        shared_block_.reset();
+        return;
+    }
+    if (ring_size_ > 0) {
+        ::munmap(buffer_, 2 * ring_size_);
+        ring_size_ = 0;
+        return;
+    }
+    if (!buffer_ || buffer_ == empty_storage_) {
+        return;
+    }
+    if (pool_) {
+        pool_->Deallocate(buffer_, capacity_);
+    } else {
+        ::free(buffer_);
+    }
+}
+
+void Buffer::DetachShared() {
+    if (Shared()) {
+        FreeStorage();
+        buffer_ = empty_storage_;
+        capacity_ = kCheapPrepend;
+        reader_index_ = kCheapPrepend;
+        writer_index_ = kCheapPrepend;
+    }
+}
+
+BufferSlice Buffer::RetrieveAsSlice(size_t len) {
+    assert(len <= ReadableBytes());
+    if (len == 0) {
+        return BufferSlice();
+    }
+    if (ring_size_ > 0) {
+        // the ring is written over again and again, slices get a copy
+        std::shared_ptr<char> copy(new char[len],
+                                   std::default_delete<char[]>());
+        std::copy(Peek(), Peek() + len, copy.get());
+        Retrieve(len);
+        return BufferSlice(copy, copy.get(), len);
+    }
+    if (!shared_block_) {
+        std::shared_ptr<event_loop::MemoryPool> pool = pool_;
+        size_t capacity = capacity_;
+        shared_block_.reset(buffer_, [pool, capacity](char *block) {
+            if (pool) {
+                pool->Deallocate(block, capacity);
+            } else {
+                ::free(block);
+            }
+        });
+    }
+    BufferSlice slice(shared_block_, Peek(), len);
+    // skip the bytes only, unlike Retrieve() which would give the block up
+    // to the slice once nothing is readable
+    reader_index_ += len;
+    crlf_scanned_ = crlf_scanned_ > len ? crlf_scanned_ - len : 0;
+    return slice;
+}
+
+// Maps @c size bytes of a memfd twice, back to back, into a reserved
+// area of twice the size. The fd is not needed once mapped.
+static char *MapRing(size_t size) {
+    int fd = ::memfd_create("muduo_buffer", MFD_CLOEXEC);
+    if (fd < 0) {
+        return nullptr;
+    }
+    char *base = nullptr;
+    if (::ftruncate(fd, size) == 0) {
+        void *area = ::mmap(nullptr, 2 * size, PROT_NONE,
+                            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (area != MAP_FAILED) {
+            char *p = static_cast<char *>(area);
+            const int prot = PROT_READ | PROT_WRITE;
+            const int flags = MAP_SHARED | MAP_FIXED;
+            if (::mmap(p, size, prot, flags, fd, 0) != MAP_FAILED &&
+                ::mmap(p + size, size, prot, flags, fd, 0) != MAP_FAILED) {
+                base = p;
+            } else {
+                ::munmap(area, 2 * size);
+            }
+        }
+    }
+    int saved_errno = errno;
+    ::close(fd);
+    errno = saved_errno;
+    return base;
+}
+
+bool Buffer::EnableRing(size_t size) {
+    const size_t page_size = ::sysconf(_SC_PAGESIZE);
+    size = (size + page_size - 1) / page_size * page_size;
+    if (ring_size_ > 0 || size <= kCheapPrepend + ReadableBytes()) {
+        errno = EINVAL;
+        return false;
+    }
+    char *base = MapRing(size);
+    if (!base) {
+        return false;
+    }
+
+    size_t readable = ReadableBytes();
+    std::copy(Peek(), static_cast<const char *>(BeginWrite()),
+              base + kCheapPrepend);
+    FreeStorage();
+    buffer_ = base;
+    ring_size_ = size;
+    reader_index_ = kCheapPrepend;
+    writer_index_ = reader_index_ + readable;
+    capacity_ = reader_index_ + ring_size_;
+    read_hint_ = 0;
+    return true;
+}
+
+void Buffer::Shrink(size_t reserve) {
+    if (ring_size_ > 0) {
+        return;
+    }
+    read_hint_ = 0;
+    if (ReadableBytes() == 0 && reserve == 0) {
+        FreeStorage();
+        buffer_ = empty_storage_;
+        capacity_ = kCheapPrepend;
+        reader_index_ = kCheapPrepend;
+        writer_index_ = kCheapPrepend;
+        return;
+    }
+
+    size_t size = kCheapPrepend + ReadableBytes() + reserve;
+    if (pool_) {
+        size = event_loop::MemoryPool::RoundUp(size);
+    }
+    if (size < capacity_) {
+        Reallocate(size);
+    }
+}
 
+ssize_t Buffer::ReadFd(int fd, int *saved_errno) {
     // saved an ioctl()/FIONREAD call to tell how much to read
     char extrabuf[65536];
+    return ReadFd(fd, saved_errno, extrabuf, sizeof(extrabuf));
+}
+
+ssize_t Buffer::ReadFd(int fd, int *saved_errno, char *scratch,
+                       size_t scratch_size, size_t max_bytes) {
+    // a ring reads no more than its free space, unless it is full
+    const bool ring = ring_size_ > 0 && WritableBytes() > 0;
+    const size_t hint = std::min(read_hint_, max_bytes);
+    if (!ring && WritableBytes() < hint) {
+        EnsureWritableBytes(hint);
+    }
+
     struct iovec vec[2];
     const size_t writable = WritableBytes();
+    const size_t in_place = std::min(writable, max_bytes);
     vec[0].iov_base = begin() + writer_index_;
-    vec[0].iov_len = writable;
-    vec[1].iov_base = extrabuf;
-    vec[1].iov_len = sizeof(extrabuf);
-    // when there is enough space in this buffer, don't read into extrabuf.
-    // when extrabuf is used, we read 128k-1 bytes at most.
-    const int iovcnt = (writable < sizeof(extrabuf)) ? 2 : 1;
+    vec[0].iov_len = in_place;
+    vec[1].iov_base = scratch;
+    vec[1].iov_len = std::min(scratch_size, max_bytes - in_place);
+    // when there is enough space in this buffer, don't read into scratch.
+    const int iovcnt =
+        (!ring && writable < scratch_size && vec[1].iov_len > 0) ? 2 : 1;
     const ssize_t n = ::readv(fd, vec, iovcnt);
     if (n < 0) {
         *saved_errno = errno;
-    } else if ((size_t)n <= writable) {
+    } else if ((size_t)n <= in_place) {
         writer_index_ += n;
     } else {
-        writer_index_ = buffer_.size();
-        Append(extrabuf, n - writable);
+        // scratch is only read into once the writable bytes are full
+        writer_index_ = capacity_;
+        Append(scratch, n - in_place);
     }
 
+    if (n > 0) {
+        AdaptReadHint(n, in_place + (iovcnt == 2 ? vec[1].iov_len : 0));
+    }
     return n;
 }
 
@@ -76,19 +348,50 @@ ssize_t Buffer::ReadFd(int fd, int *saved_errno, struct sockaddr_in6 *peer) {
     } else if ((size_t)n <= writable) {
         writer_index_ += n;
     } else {
-        writer_index_ = buffer_.size();
+        writer_index_ = capacity_;
         Append(extrabuf, n - writable);
     }
 
     return n;
 }
 
+void Buffer::AdaptReadHint(size_t n, size_t offered) {
+    if (n >= offered) {
+        // more is likely pending, read it in place next time
+        read_hint_ = std::min(std::max(read_hint_ * 2, n), kMaxReadHint);
+    } else if (n < read_hint_ / 4) {
+        read_hint_ /= 2;
+        if (read_hint_ < kMinReadHint) {
+            read_hint_ = 0;
+        }
+    }
+}
+
 void Buffer::Append(const char *data, size_t len) {
     EnsureWritableBytes(len);
     std::copy(data, data + len, BeginWrite());
     HasWritten(len);
 }
 
+void Buffer::Prepend(const void *data, size_t len) {
+    if (!HasStorage() || Shared() ||
+        (ring_size_ > 0 &&
+         (len > PrependableBytes() || len > WritableBytes()))) {
+        // neither the shared empty storage nor bytes referenced by slices
+        // may be written, readable bytes move to a block of their own
+        Reallocate(kCheapPrepend + ReadableBytes() + WritableBytes());
+    }
+    assert(len <= PrependableBytes());
+    reader_index_ -= len;
+    const char *d = static_cast<const char *>(data);
+    std::copy(d, d + len, begin() + reader_index_);
+    crlf_scanned_ = 0;
+    if (ring_size_ > 0) {
+        // the prepended bytes came out of the free space
+        RewindRing();
+    }
+}
+
 void Buffer::EnsureWritableBytes(size_t len) {
     if (WritableBytes() < len) {
         MakeSpace(len);
@@ -109,9 +412,17 @@ void Buffer::MakeSpace(size_t len) {
     //     }
     // } else
     // 相当于合并了以上代码
-    if (WritableBytes() + PrependableBytes() < len + kCheapPrepend) {
-        // FIXME: move readable data
-        buffer_.resize(writer_index_ + len);
+    const size_t needed = kCheapPrepend + ReadableBytes() + len;
+    const size_t size =
+        ring_size_ > 0 ? kCheapPrepend + ring_size_ : capacity_;
+    if (needed > size) {
+        // grow into a new block, nothing is zero filled. Growing
+        // geometrically keeps appending amortized O(1).
+        Reallocate(std::max(needed, 2 * size));
+    } else if (Shared()) {
+        // it would fit after compaction, but retrieved bytes referenced by
+        // slices must stay as they are
+        Reallocate(size);
     } else {
         // move readable data to the front, make space inside buffer
         // 发生了读取数据索引移位才需要移动数据
@@ -1,10 +1,16 @@
 #ifndef __MUDUO_NET_BUFFER_H_
 #define __MUDUO_NET_BUFFER_H_
 
+#include "buffer_slice.h"
+#include "delimiter_search.h"
+#include "eventloop/endian.h"
+#include "eventloop/memory_pool.h"
+#include "logger/string_piece.h"
+
 #include <algorithm>
 #include <cstring>
+#include <memory>
 #include <string>
-#include <vector>
 
 #include <arpa/inet.h>
 #include <assert.h>
@@ -22,27 +28,64 @@ namespace net {
 /// |                   |                  |                  |
 /// 0      <=      readerIndex   <=   writerIndex    <=     size
 /// @endcode
-
+///
+/// Storage is a raw block, grown without zero filling. Given a MemoryPool,
+/// usually the one of the EventLoop owning the connection, blocks are taken
+/// from and returned to it, otherwise from malloc. Shrink() hands unused
+/// capacity back, down to no storage at all while the buffer is empty.
+///
+/// RetrieveAsSlice() hands retrieved bytes out without copying, the block
+/// is then shared with the slices. While it is, bytes before the reader
+/// index are never overwritten: compaction and RetrieveAll() move on to a
+/// new block instead.
+///
+/// EnableRing() switches to a fixed size ring, a memfd mapped twice back to
+/// back: readable bytes wrapping around the end of the ring are still
+/// contiguous in memory, so the ring never compacts. capacity() then moves
+/// along with the reader index, and a write that does not fit migrates the
+/// buffer back to a pooled linear block.
 class Buffer {
 public:
     static const size_t kCheapPrepend = 8;
     static const size_t kInitialSize = 1024;
 
-    explicit Buffer(size_t initial_size = kInitialSize)
-        : buffer_(kCheapPrepend + initial_size),
-          reader_index_(kCheapPrepend),
-          writer_index_(kCheapPrepend) {}
+    explicit Buffer(size_t initial_size = kInitialSize);
 
-    explicit Buffer(size_t prepend_size, size_t initial_size = kInitialSize)
-        : buffer_(prepend_size + initial_size),
-          reader_index_(prepend_size),
-          writer_index_(prepend_size) {
-        assert(prepend_size >= 10);
-    }
+    explicit Buffer(size_t prepend_size, size_t initial_size = kInitialSize);
+
+    explicit Buffer(std::shared_ptr<event_loop::MemoryPool> pool,
+                    size_t initial_size = kInitialSize);
+
+    Buffer(const Buffer &rhs);
+    Buffer(Buffer &&rhs);
+    Buffer &operator=(Buffer rhs);
+    ~Buffer();
+
+    void swap(Buffer &rhs);
+
+    size_t capacity() const { return capacity_; }
+
+    /// Whether a block is held, false after Shrink(0) on an empty buffer.
+    bool HasStorage() const { return buffer_ != empty_storage_; }
+
+    /// Releases capacity beyond the readable bytes plus @c reserve, and
+    /// forgets the read size learnt from bulk reads. An empty buffer shrunk
+    /// with no reserve frees its block and holds no memory until written.
+    void Shrink(size_t reserve);
+
+    ///
+    /// Moves the readable bytes into a ring of @c size bytes, rounded up to
+    /// pages. Reads then take at most the free space of the ring, and
+    /// slices are copied out of it. Shrink() leaves a ring alone.
+    /// @return false with errno set if mapping fails, nothing changes then
+    ///
+    bool EnableRing(size_t size);
+
+    bool ring() const { return ring_size_ > 0; }
 
     size_t ReadableBytes() const { return writer_index_ - reader_index_; }
 
-    size_t WritableBytes() const { return buffer_.size() - writer_index_; }
+    size_t WritableBytes() const { return capacity_ - writer_index_; }
 
     size_t PrependableBytes() const { return reader_index_; }
 
@@ -52,30 +95,177 @@ public:
     void Unwrite(size_t len) {
         assert(len <= ReadableBytes());
         writer_index_ -= len;
+        crlf_scanned_ = std::min(crlf_scanned_, ReadableBytes());
     }
 
     const char *Peek() const { return begin() + reader_index_; }
 
+    /// Incremental, resumes after the bytes a previous call has already
+    /// scanned, so a line arriving in pieces is not rescanned from Peek().
     const char *FindCRLF() const {
-        // FIXME: replace with memmem()?
-        const char *crlf = std::search(Peek(), BeginWrite(), kCRLF, kCRLF + 2);
-        return crlf == BeginWrite() ? nullptr : crlf;
+        // the last byte scanned may be the '\r' of a CRLF split by a read
+        const char *start =
+            Peek() + (crlf_scanned_ > 0 ? crlf_scanned_ - 1 : 0);
+        const char *crlf = search::FindCRLF(start, BeginWrite());
+        crlf_scanned_ = crlf ? crlf - Peek() : ReadableBytes();
+        return crlf;
     }
 
     const char *FindCRLF(const char *start) const {
         assert(Peek() <= start);
         assert(start <= BeginWrite());
-        // FIXME: replace with memmem()?
-        const char *crlf = std::search(start, BeginWrite(), kCRLF, kCRLF + 2);
-        return crlf == BeginWrite() ? nullptr : crlf;
+        return search::FindCRLF(start, BeginWrite());
+    }
+
+    const char *FindByte(char c) const { return FindByte(Peek(), c); }
+
+    const char *FindByte(const char *start, char c) const {
+        assert(Peek() <= start);
+        assert(start <= BeginWrite());
+        return search::FindByte(start, BeginWrite(), c);
+    }
+
+    /// Resume a search by passing the previous end of readable bytes, less
+    /// len - 1, as @c start.
+    const char *FindDelimiter(const char *delim, size_t len) const {
+        return FindDelimiter(Peek(), delim, len);
+    }
+
+    const char *FindDelimiter(const char *start, const char *delim,
+                              size_t len) const {
+        assert(Peek() <= start);
+        assert(start <= BeginWrite());
+        return search::FindDelimiter(start, BeginWrite(), delim, len);
     }
 
     ssize_t ReadFd(int fd, int *saved_errno);
 
+    /// Reads into writable bytes, overflowing into @c scratch, which is
+    /// then appended. A connection streaming bulk data grows the buffer
+    /// ahead of the read, sized from its recent reads, so the data mostly
+    /// lands in place instead of being copied out of @c scratch.
+    /// Reads no more than @c max_bytes.
+    ssize_t ReadFd(int fd, int *saved_errno, char *scratch,
+                   size_t scratch_size,
+                   size_t max_bytes = static_cast<size_t>(-1));
+
     ssize_t ReadFd(int fd, int *saved_errno, struct sockaddr_in6 *peer);
 
     void Append(const char *data, size_t len);
 
+    void Append(const void *data, size_t len) {
+        Append(static_cast<const char *>(data), len);
+    }
+
+    ///
+    /// Append int64_t using network endian
+    ///
+    void AppendInt64(int64_t x) {
+        int64_t be64 = HostToNetwork64(x);
+        Append(&be64, sizeof be64);
+    }
+
+    ///
+    /// Append int32_t using network endian
+    ///
+    void AppendInt32(int32_t x) {
+        int32_t be32 = HostToNetwork32(x);
+        Append(&be32, sizeof be32);
+    }
+
+    void AppendInt16(int16_t x) {
+        int16_t be16 = HostToNetwork16(x);
+        Append(&be16, sizeof be16);
+    }
+
+    void AppendInt8(int8_t x) { Append(&x, sizeof x); }
+
+    ///
+    /// Writes @c len bytes in front of the readable bytes, in place.
+    /// Requires len <= PrependableBytes(), i.e. kCheapPrepend unless the
+    /// buffer was constructed with a larger prepend size.
+    ///
+    void Prepend(const void *data, size_t len);
+
+    void PrependInt64(int64_t x) {
+        int64_t be64 = HostToNetwork64(x);
+        Prepend(&be64, sizeof be64);
+    }
+
+    void PrependInt32(int32_t x) {
+        int32_t be32 = HostToNetwork32(x);
+        Prepend(&be32, sizeof be32);
+    }
+
+    void PrependInt16(int16_t x) {
+        int16_t be16 = HostToNetwork16(x);
+        Prepend(&be16, sizeof be16);
+    }
+
+    void PrependInt8(int8_t x) { Prepend(&x, sizeof x); }
+
+    ///
+    /// Peek int64_t from network endian
+    ///
+    /// Require: ReadableBytes() >= sizeof(int64_t)
+    int64_t PeekInt64() const {
+        assert(ReadableBytes() >= sizeof(int64_t));
+        int64_t be64 = 0;
+        ::memcpy(&be64, Peek(), sizeof be64);
+        return NetworkToHost64(be64);
+    }
+
+    ///
+    /// Peek int32_t from network endian
+    ///
+    /// Require: ReadableBytes() >= sizeof(int32_t)
+    int32_t PeekInt32() const {
+        assert(ReadableBytes() >= sizeof(int32_t));
+        int32_t be32 = 0;
+        ::memcpy(&be32, Peek(), sizeof be32);
+        return NetworkToHost32(be32);
+    }
+
+    int16_t PeekInt16() const {
+        assert(ReadableBytes() >= sizeof(int16_t));
+        int16_t be16 = 0;
+        ::memcpy(&be16, Peek(), sizeof be16);
+        return NetworkToHost16(be16);
+    }
+
+    int8_t PeekInt8() const {
+        assert(ReadableBytes() >= sizeof(int8_t));
+        return *Peek();
+    }
+
+    ///
+    /// Read int64_t from network endian, retrieving it
+    ///
+    /// Require: ReadableBytes() >= sizeof(int64_t)
+    int64_t ReadInt64() {
+        int64_t result = PeekInt64();
+        Retrieve(sizeof result);
+        return result;
+    }
+
+    int32_t ReadInt32() {
+        int32_t result = PeekInt32();
+        Retrieve(sizeof result);
+        return result;
+    }
+
+    int16_t ReadInt16() {
+        int16_t result = PeekInt16();
+        Retrieve(sizeof result);
+        return result;
+    }
+
+    int8_t ReadInt8() {
+        int8_t result = PeekInt8();
+        Retrieve(sizeof result);
+        return result;
+    }
+
     std::string RetrieveAllAsString() {
         return RetrieveAsString(ReadableBytes());
     }
@@ -87,6 +277,13 @@ public:
         return result;
     }
 
+    /// Retrieves @c len bytes as a slice of this buffer's storage.
+    BufferSlice RetrieveAsSlice(size_t len);
+
+    BufferSlice RetrieveAllAsSlice() {
+        return RetrieveAsSlice(ReadableBytes());
+    }
+
     // for debug, do not change index
     std::string TryRetrieveAllAsString() {
         return TryRetrieveAsString(ReadableBytes());
@@ -111,15 +308,87 @@ public:
     void Retrieve(size_t len) {
         assert(len <= ReadableBytes());
         if (len < ReadableBytes()) {
-            reader_index_ += len;
+            Skip(len);
         } else {
             RetrieveAll();
         }
     }
 
     void RetrieveAll() {
+        if (shared_block_) {
+            DetachShared();
+        }
         reader_index_ = kCheapPrepend;
         writer_index_ = kCheapPrepend;
+        crlf_scanned_ = 0;
+        if (ring_size_ > 0) {
+            capacity_ = kCheapPrepend + ring_size_;
+        }
+    }
+
+    ///
+    /// Views of readable bytes, for parsing without copying.
+    ///
+    /// A view points into the buffer and is invalidated by any non-const
+    /// call on it: appending may move the bytes, and RetrieveAll(), Shrink()
+    /// or the connection's idle reclamation may free the storage, even
+    /// with nothing written. The retrieving calls below only skip the
+    /// bytes, so the view they return is valid until the next such call.
+    ///
+    StringPiece ToStringPiece() const {
+        return StringPiece(Peek(), static_cast<int>(ReadableBytes()));
+    }
+
+    StringPiece PeekAsStringPiece(size_t len) const {
+        assert(len <= ReadableBytes());
+        return StringPiece(Peek(), static_cast<int>(len));
+    }
+
+    StringPiece RetrieveAsStringPiece(size_t len) {
+        StringPiece result = PeekAsStringPiece(len);
+        Skip(len);
+        return result;
+    }
+
+    /// @param line the first line ended by \r\n
+    /// @return false if no complete line is readable yet
+    bool PeekCRLFLine(StringPiece *line, bool include_crlf = false) const {
+        const char *crlf = FindCRLF();
+        if (!crlf)
+            return false;
+
+        line->set(Peek(), static_cast<int>(include_crlf ? crlf + 2 - Peek()
+                                                        : crlf - Peek()));
+        return true;
+    }
+
+    /// Like PeekCRLFLine(), then retrieves the line with its \r\n.
+    bool RetrieveCRLFLine(StringPiece *line, bool include_crlf = false) {
+        if (!PeekCRLFLine(line, include_crlf))
+            return false;
+
+        Skip(line->size() + (include_crlf ? 0 : 2));
+        return true;
+    }
+
+    /// @param token readable bytes up to the first @c delim, without it
+    /// @return false if @c delim is not readable yet
+    bool PeekToken(const StringPiece &delim, StringPiece *token) const {
+        const char *end = FindDelimiter(delim.data(), delim.size());
+        if (!end)
+            return false;
+
+        token->set(Peek(), static_cast<int>(end - Peek()));
+        return true;
+    }
+
+    /// Like PeekToken(), then retrieves the token and @c delim.
+    bool RetrieveToken(const StringPiece &delim, StringPiece *token) {
+        if (!PeekToken(delim, token))
+            return false;
+
+        Skip(token->size() + delim.size());
+        return true;
     }
 
     /// @brief 接收以\r\n结尾的第一行数据，
@@ -137,25 +406,78 @@ public:
     }
 
 private:
-    char *begin() { return &*buffer_.begin(); }
+    char *begin() { return buffer_; }
 
-    const char *begin() const { return &*buffer_.begin(); }
+    const char *begin() const { return buffer_; }
 
     char *BeginWrite() { return begin() + writer_index_; }
 
     const char *BeginWrite() const { return begin() + writer_index_; }
 
+    // retrieves without giving up the storage, unlike RetrieveAll(), so
+    // views of the skipped bytes stay valid
+    void Skip(size_t len) {
+        assert(len <= ReadableBytes());
+        reader_index_ += len;
+        crlf_scanned_ = crlf_scanned_ > len ? crlf_scanned_ - len : 0;
+        if (ring_size_ > 0) {
+            RewindRing();
+        }
+    }
+
     void HasWritten(size_t len) {
         assert(len <= WritableBytes());
         writer_index_ += len;
     }
 
+    // replaces storage with a block of at least @c size bytes,
+    // readable bytes are moved to its front
+    void Reallocate(size_t size);
+    void FreeStorage();
+
+    // whether slices still reference the storage
+    bool Shared() const {
+        return shared_block_ && shared_block_.use_count() > 1;
+    }
+    // drops storage referenced by slices, leaving no storage
+    void DetachShared();
+
+    // keeps the reader index within the first mapping of the ring, and the
+    // writable bytes up to a full ring ahead of it
+    void RewindRing() {
+        if (reader_index_ >= ring_size_) {
+            reader_index_ -= ring_size_;
+            writer_index_ -= ring_size_;
+        }
+        capacity_ = reader_index_ + ring_size_;
+    }
+
+    // doubles read_hint_ while reads fill all they were offered,
+    // halves it while they stay well below it
+    void AdaptReadHint(size_t n, size_t offered);
+
+    static const size_t kMinReadHint = 4 * 1024;
+    static const size_t kMaxReadHint = 512 * 1024;
+
 private:
-    std::vector<char> buffer_;
+    std::shared_ptr<event_loop::MemoryPool> pool_;
+    char *buffer_;
+    std::size_t capacity_;
     std::size_t reader_index_;
     std::size_t writer_index_;
-
-    static const char kCRLF[];
+    // bytes to have writable before reading, 0 until reads fill up
+    std::size_t read_hint_;
+    // readable bytes known to hold no CRLF, from the last FindCRLF()
+    mutable std::size_t crlf_scanned_;
+    // owns buffer_ once a slice has been taken, returning it to the pool
+    // when the last reference goes
+    std::shared_ptr<char> shared_block_;
+    // size of the ring buffer_ maps twice, 0 for linear storage
+    std::size_t ring_size_;
+
+    // storage of buffers holding no block, with nothing writable it is
+    // never written to
+    static char empty_storage_[kCheapPrepend];
 };
 } // namespace net
 } // namespace muduo
@@ -0,0 +1,237 @@
+#include "buffer_chain.h"
+#include "inet_socket.h"
+
+#include <algorithm>
+#include <assert.h>
+#include <climits>
+#include <cstdlib>
+#include <errno.h>
+#include <new>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <utility>
+
+namespace muduo {
+namespace net {
+
+// writev(2) accepts at most IOV_MAX segments
+constexpr int kMaxIovecs = IOV_MAX;
+
+static_assert(event_loop::MemoryPool::kMinBlockSize <= BufferChain::kSlabSize &&
+                  (BufferChain::kSlabSize & (BufferChain::kSlabSize - 1)) ==
+                      0,
+              "slabs fill a pool size class exactly");
+
+BufferChain::BufferChain(std::shared_ptr<event_loop::MemoryPool> pool)
+    : pool_(std::move(pool)), readable_(0), file_bytes_(0) {}
+
+BufferChain::~BufferChain() { RetrieveAll(); }
+
+void BufferChain::Append(const char *data, size_t len) {
+    readable_ += len;
+    while (len > 0) {
+        if (slabs_.empty() || !Appendable(slabs_.back())) {
+            char *slab = AllocateSlab();
+            slabs_.push_back(Slab{slab, slab, 0, 0, BufferSlice(), -1, 0});
+        }
+        Slab &tail = slabs_.back();
+        size_t n = std::min(len, kSlabSize - tail.write_index);
+        std::copy(data, data + n, tail.owned + tail.write_index);
+        tail.write_index += n;
+        data += n;
+        len -= n;
+    }
+}
+
+void BufferChain::Append(const BufferSlice &slice) {
+    if (slice.size() < kMinSliceReference) {
+        Append(slice.data(), slice.size());
+        return;
+    }
+    // free the drained slab kept for appending, like AppendFile(), a slice
+    // sent with MSG_ZEROCOPY must reach the front once everything before it
+    // is sent
+    Shrink();
+    readable_ += slice.size();
+    slabs_.push_back(
+        Slab{nullptr, slice.data(), 0, slice.size(), slice, -1, 0});
+}
+
+void BufferChain::AppendFile(int fd, off_t offset, size_t len) {
+    if (len == 0) {
+        ::close(fd);
+        return;
+    }
+    if (readable_ == 0) {
+        // free the drained slab kept for appending, WriteFd() expects a file
+        // range to be at the front once everything before it is sent
+        RetrieveAll();
+    }
+    readable_ += len;
+    file_bytes_ += len;
+    slabs_.push_back(Slab{nullptr, nullptr, 0, len, BufferSlice(), fd, offset});
+}
+
+void BufferChain::Retrieve(size_t len) {
+    assert(len <= readable_);
+    readable_ -= len;
+    while (len > 0) {
+        Slab &head = slabs_.front();
+        size_t n = std::min(len, head.write_index - head.read_index);
+        head.read_index += n;
+        if (head.file_fd >= 0) {
+            file_bytes_ -= n;
+        }
+        len -= n;
+        // the tail slab is kept while it still has room for appending
+        if (head.read_index == head.write_index &&
+            (slabs_.size() > 1 || !Appendable(head))) {
+            PopFront();
+        }
+    }
+    if (readable_ == 0 && !slabs_.empty()) {
+        // reuse the empty tail slab from its beginning
+        assert(slabs_.size() == 1);
+        slabs_.front().read_index = 0;
+        slabs_.front().write_index = 0;
+    }
+}
+
+void BufferChain::RetrieveAll() {
+    while (!slabs_.empty()) {
+        PopFront();
+    }
+    readable_ = 0;
+    file_bytes_ = 0;
+}
+
+void BufferChain::PopFront() {
+    if (slabs_.front().owned) {
+        FreeSlab(slabs_.front().owned);
+    }
+    if (slabs_.front().file_fd >= 0) {
+        ::close(slabs_.front().file_fd);
+    }
+    slabs_.pop_front();
+}
+
+void BufferChain::Shrink() {
+    if (readable_ == 0) {
+        RetrieveAll();
+    }
+}
+
+ssize_t BufferChain::WriteFd(int fd, int *saved_errno,
+                             size_t zerocopy_threshold,
+                             BufferSlice *zerocopy_slice) {
+    if (!slabs_.empty() && slabs_.front().file_fd >= 0) {
+        return SendFileFront(fd, saved_errno);
+    }
+    if (!slabs_.empty() &&
+        ZeroCopyable(slabs_.front(), zerocopy_threshold)) {
+        return SendZeroCopyFront(fd, saved_errno, zerocopy_slice);
+    }
+
+    struct iovec vec[kMaxIovecs];
+    int iovcnt = 0;
+    for (const Slab &slab : slabs_) {
+        if (iovcnt == kMaxIovecs || slab.file_fd >= 0 ||
+            ZeroCopyable(slab, zerocopy_threshold)) {
+            break;
+        }
+        if (slab.write_index > slab.read_index) {
+            // writev(2) only reads, iov_base is not const for readv(2)
+            vec[iovcnt].iov_base =
+                const_cast<char *>(slab.data) + slab.read_index;
+            vec[iovcnt].iov_len = slab.write_index - slab.read_index;
+            ++iovcnt;
+        }
+    }
+    if (iovcnt == 0) {
+        return 0;
+    }
+
+    const ssize_t n = ::writev(fd, vec, iovcnt);
+    if (n < 0) {
+        *saved_errno = errno;
+    } else {
+        Retrieve(n);
+    }
+    return n;
+}
+
+ssize_t BufferChain::SendFileFront(int fd, int *saved_errno) {
+    const Slab &head = slabs_.front();
+    const size_t remaining = head.write_index - head.read_index;
+    off_t offset = head.file_offset + head.read_index;
+    const ssize_t n =
+        sockets::SendFile(fd, head.file_fd, &offset, remaining);
+    if (n > 0) {
+        Retrieve(n);
+        return n;
+    }
+    if (n < 0 && (errno == EAGAIN || errno == EINTR)) {
+        *saved_errno = errno;
+        return -1;
+    }
+    // the file is shorter than the range, or cannot be sent at all, drop
+    // the rest of the range so it is reported once instead of retried
+    *saved_errno = n == 0 ? ENODATA : errno;
+    Retrieve(remaining);
+    return -1;
+}
+
+ssize_t BufferChain::SendZeroCopyFront(int fd, int *saved_errno,
+                                       BufferSlice *zerocopy_slice) {
+    const Slab &head = slabs_.front();
+    bool zerocopy = false;
+    const ssize_t n =
+        sockets::SendZeroCopy(fd, head.data + head.read_index,
+                              head.write_index - head.read_index, &zerocopy);
+    if (n < 0) {
+        *saved_errno = errno;
+    } else {
+        if (zerocopy) {
+            *zerocopy_slice = head.slice;
+        }
+        Retrieve(n);
+    }
+    return n;
+}
+
+char *BufferChain::AllocateSlab() {
+    char *slab = nullptr;
+    if (pool_) {
+        size_t capacity;
+        slab = pool_->Allocate(kSlabSize, &capacity);
+    } else {
+        slab = static_cast<char *>(::malloc(kSlabSize));
+    }
+    if (!slab) {
+        throw std::bad_alloc();
+    }
+    return slab;
+}
+
+void BufferChain::FreeSlab(char *slab) {
+    if (pool_) {
+        pool_->Deallocate(slab, kSlabSize);
+    } else {
+        ::free(slab);
+    }
+}
+
+std::string BufferChain::TryRetrieveAllAsString() const {
+    std::string result;
+    result.reserve(readable_);
+    for (const Slab &slab : slabs_) {
+        if (slab.data) {
+            result.append(slab.data + slab.read_index,
+                          slab.write_index - slab.read_index);
+        }
+    }
+    return result;
+}
+
+} // namespace net
+} // namespace muduo
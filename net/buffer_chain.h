@@ -0,0 +1,111 @@
+#ifndef __MUDUO_NET_BUFFER_CHAIN_H_
+#define __MUDUO_NET_BUFFER_CHAIN_H_
+
+#include "buffer_slice.h"
+#include "eventloop/memory_pool.h"
+#include "eventloop/noncopyable.h"
+
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <string>
+
+#include <sys/types.h>
+
+namespace muduo {
+namespace net {
+
+/// An output buffer made of a chain of fixed size slabs.
+///
+/// @code
+/// +-----------------+   +-----------------+   +-----------------+
+/// | xxx|  readable  |-->|    readable     |-->| readable |       |
+/// +-----------------+   +-----------------+   +-----------------+
+///      ^ read_index                                      ^ write_index
+/// @endcode
+///
+/// Appending never moves queued bytes, a slab is freed as soon as it is
+/// drained, and WriteFd() gathers up to IOV_MAX slabs in one writev(2).
+/// Slabs come from @c pool if given, otherwise from malloc. A BufferSlice
+/// is queued as a node of its own, referencing its bytes in place, and a
+/// file range as a node sent with sendfile(2), never read into memory.
+class BufferChain : Noncopyable {
+public:
+    static const size_t kSlabSize = 16 * 1024;
+    // shorter slices are copied, cheaper than an iovec of their own
+    static const size_t kMinSliceReference = 1024;
+
+    explicit BufferChain(
+        std::shared_ptr<event_loop::MemoryPool> pool = nullptr);
+    ~BufferChain();
+
+    size_t ReadableBytes() const { return readable_; }
+
+    void Append(const char *data, size_t len);
+    void Append(const BufferSlice &slice);
+    /// Queues @c len bytes of @c fd from @c offset, taking the fd over.
+    /// It is closed once the range is sent or dropped.
+    void AppendFile(int fd, off_t offset, size_t len);
+
+    /// Bytes of ReadableBytes() queued in file ranges, not held in memory.
+    size_t FileBytes() const { return file_bytes_; }
+
+    void Retrieve(size_t len);
+
+    void RetrieveAll();
+
+    /// Frees the slab kept for appending once nothing is queued.
+    void Shrink();
+
+    /// Writes as many bytes as the fd takes, and retrieves them. Slabs
+    /// before a file range are gathered, the range is sent by a later call.
+    ///
+    /// With @c zerocopy_threshold, a queued slice of at least that many
+    /// bytes is sent on its own with MSG_ZEROCOPY. If it was, the slice is
+    /// copied to *zerocopy_slice, which the caller must keep until the
+    /// kernel completes the send.
+    /// @return bytes written, or -1 with *saved_errno set
+    ssize_t WriteFd(int fd, int *saved_errno, size_t zerocopy_threshold = 0,
+                    BufferSlice *zerocopy_slice = nullptr);
+
+    // for debug, do not change index, file ranges are left out
+    std::string TryRetrieveAllAsString() const;
+
+private:
+    char *AllocateSlab();
+    void FreeSlab(char *slab);
+
+    struct Slab {
+        // nullptr if the node references a slice or a file
+        char *owned;
+        const char *data;
+        size_t read_index;
+        size_t write_index;
+        BufferSlice slice;
+        // -1 unless the node is a file range, starting at file_offset
+        int file_fd;
+        off_t file_offset;
+    };
+
+    static bool Appendable(const Slab &slab) {
+        return slab.owned && slab.write_index < kSlabSize;
+    }
+    void PopFront();
+    ssize_t SendFileFront(int fd, int *saved_errno);
+    ssize_t SendZeroCopyFront(int fd, int *saved_errno,
+                              BufferSlice *zerocopy_slice);
+    static bool ZeroCopyable(const Slab &slab, size_t threshold) {
+        return threshold > 0 && !slab.owned && slab.file_fd < 0 &&
+               slab.write_index - slab.read_index >= threshold;
+    }
+
+    std::shared_ptr<event_loop::MemoryPool> pool_;
+    std::deque<Slab> slabs_;
+    size_t readable_;
+    size_t file_bytes_;
+};
+
+} // namespace net
+} // namespace muduo
+
+#endif /* __MUDUO_NET_BUFFER_CHAIN_H_ */
@@ -0,0 +1,63 @@
+#ifndef __MUDUO_NET_BUFFER_SLICE_H_
+#define __MUDUO_NET_BUFFER_SLICE_H_
+
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <utility>
+
+namespace muduo {
+namespace net {
+
+///
+/// An immutable view of bytes retrieved from a Buffer, sharing its storage.
+///
+/// The storage block stays alive as long as any slice references it. The
+/// Buffer never writes to retrieved bytes while they are shared, so a slice
+/// may be copied, sent on any TcpConnection and read from any thread.
+///
+class BufferSlice {
+public:
+    BufferSlice() : data_(nullptr), size_(0) {}
+
+    BufferSlice(std::shared_ptr<const char> block, const char *data,
+                size_t size)
+        : block_(std::move(block)), data_(data), size_(size) {}
+
+    /// Takes @c str over, its bytes are not copied.
+    explicit BufferSlice(std::string &&str) {
+        std::shared_ptr<std::string> holder =
+            std::make_shared<std::string>(std::move(str));
+        data_ = holder->data();
+        size_ = holder->size();
+        block_ = std::shared_ptr<const char>(holder, data_);
+    }
+
+    const char *data() const { return data_; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    /// Slice of @c len bytes from @c offset, sharing the same block.
+    BufferSlice Slice(size_t offset, size_t len) const {
+        assert(offset + len <= size_);
+        return BufferSlice(block_, data_ + offset, len);
+    }
+
+    BufferSlice Slice(size_t offset) const {
+        assert(offset <= size_);
+        return Slice(offset, size_ - offset);
+    }
+
+    std::string ToString() const { return std::string(data_, size_); }
+
+private:
+    std::shared_ptr<const char> block_;
+    const char *data_;
+    size_t size_;
+};
+
+} // namespace net
+} // namespace muduo
+
+#endif /* __MUDUO_NET_BUFFER_SLICE_H_ */
@@ -0,0 +1,145 @@
+#include "delimiter_search.h"
+
+#include <cstring>
+#include <string.h>
+
+#if defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__))
+#define MUDUO_NET_SEARCH_X86 1
+#include <immintrin.h>
+#endif
+
+namespace muduo {
+namespace net {
+namespace search {
+
+namespace {
+
+#ifdef MUDUO_NET_SEARCH_X86
+
+// positions left over by a kernel, fewer than a vector plus the delimiter
+const char *FindScalar(const char *p, const char *end, const char *delim,
+                       size_t len) {
+    for (; end - p >= static_cast<ptrdiff_t>(len); ++p) {
+        if (p[0] == delim[0] && p[len - 1] == delim[len - 1] &&
+            ::memcmp(p, delim, len) == 0) {
+            return p;
+        }
+    }
+    return nullptr;
+}
+
+// Each block tests the positions p..p+15 at once: one load at p compared
+// to the first delimiter byte, one at p+len-1 compared to the last, and
+// only positions matching both are compared in full.
+const char *FindSse2(const char *p, const char *end, const char *delim,
+                     size_t len) {
+    const __m128i first = _mm_set1_epi8(delim[0]);
+    const __m128i last = _mm_set1_epi8(delim[len - 1]);
+    while (end - p >= static_cast<ptrdiff_t>(len - 1 + 16)) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        __m128i b =
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + len - 1));
+        unsigned mask = _mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(a, first), _mm_cmpeq_epi8(b, last)));
+        while (mask) {
+            int offset = __builtin_ctz(mask);
+            if (len <= 2 ||
+                ::memcmp(p + offset + 1, delim + 1, len - 2) == 0) {
+                return p + offset;
+            }
+            mask &= mask - 1;
+        }
+        p += 16;
+    }
+    return FindScalar(p, end, delim, len);
+}
+
+__attribute__((target("avx2"))) const char *
+FindAvx2(const char *p, const char *end, const char *delim, size_t len) {
+    const __m256i first = _mm256_set1_epi8(delim[0]);
+    const __m256i last = _mm256_set1_epi8(delim[len - 1]);
+    while (end - p >= static_cast<ptrdiff_t>(len - 1 + 32)) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+        __m256i b = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i *>(p + len - 1));
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_cmpeq_epi8(a, first),
+                             _mm256_cmpeq_epi8(b, last))));
+        while (mask) {
+            int offset = __builtin_ctz(mask);
+            if (len <= 2 ||
+                ::memcmp(p + offset + 1, delim + 1, len - 2) == 0) {
+                return p + offset;
+            }
+            mask &= mask - 1;
+        }
+        p += 32;
+    }
+    return FindSse2(p, end, delim, len);
+}
+
+typedef const char *(*Kernel)(const char *, const char *, const char *,
+                              size_t);
+
+struct Dispatch {
+    Kernel kernel;
+    const char *name;
+};
+
+Dispatch Choose() {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return Dispatch{FindAvx2, "avx2"};
+    }
+    return Dispatch{FindSse2, "sse2"};
+}
+
+const Dispatch &Active() {
+    static const Dispatch dispatch = Choose();
+    return dispatch;
+}
+
+#endif // MUDUO_NET_SEARCH_X86
+
+} // namespace
+
+const char *FindByte(const char *begin, const char *end, char c) {
+#ifdef MUDUO_NET_SEARCH_X86
+    return Active().kernel(begin, end, &c, 1);
+#else
+    return static_cast<const char *>(::memchr(begin, c, end - begin));
+#endif
+}
+
+const char *FindCRLF(const char *begin, const char *end) {
+    return FindDelimiter(begin, end, "\r\n", 2);
+}
+
+const char *FindDelimiter(const char *begin, const char *end,
+                          const char *delim, size_t len) {
+    if (len == 0) {
+        return begin;
+    }
+    if (end - begin < static_cast<ptrdiff_t>(len)) {
+        return nullptr;
+    }
+#ifdef MUDUO_NET_SEARCH_X86
+    if (len <= kMaxShortDelimiter) {
+        return Active().kernel(begin, end, delim, len);
+    }
+#endif
+    return static_cast<const char *>(
+        ::memmem(begin, end - begin, delim, len));
+}
+
+const char *KernelName() {
+#ifdef MUDUO_NET_SEARCH_X86
+    return Active().name;
+#else
+    return "generic";
+#endif
+}
+
+} // namespace search
+} // namespace net
+} // namespace muduo
@@ -0,0 +1,35 @@
+#ifndef __MUDUO_NET_DELIMITER_SEARCH_H_
+#define __MUDUO_NET_DELIMITER_SEARCH_H_
+
+#include <cstddef>
+
+namespace muduo {
+namespace net {
+
+///
+/// Delimiter search in [begin, end), vectorized on x86.
+///
+/// AVX2 or SSE2 kernels are picked once at runtime, from what the CPU
+/// supports. Candidates are filtered on the first and last byte of the
+/// delimiter, so short delimiters such as "\r\n" or "\r\n\r\n" take one
+/// compare per byte. Delimiters longer than kMaxShortDelimiter fall back
+/// to memmem(). Other CPUs use memchr() and memmem().
+///
+namespace search {
+
+const size_t kMaxShortDelimiter = 16;
+
+/// @return first occurrence, or nullptr
+const char *FindByte(const char *begin, const char *end, char c);
+const char *FindCRLF(const char *begin, const char *end);
+const char *FindDelimiter(const char *begin, const char *end,
+                          const char *delim, size_t len);
+
+/// "avx2", "sse2" or "generic"
+const char *KernelName();
+
+} // namespace search
+} // namespace net
+} // namespace muduo
+
+#endif /* __MUDUO_NET_DELIMITER_SEARCH_H_ */
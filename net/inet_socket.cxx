@@ -4,9 +4,15 @@
 
 #include <arpa/inet.h>
 #include <assert.h>
+#include <linux/errqueue.h>
 #include <netinet/tcp.h>
+#include <sys/sendfile.h>
 #include <unistd.h>
 
+#ifndef SO_EE_ORIGIN_ZEROCOPY
+#define SO_EE_ORIGIN_ZEROCOPY 5
+#endif
+
 namespace muduo {
 namespace net {
 
@@ -45,6 +51,27 @@ void Socket::SetTcpNoDelay(bool on) {
     // FIXME CHECK
 }
 
+bool Socket::SetTcpNotSentLowat(size_t bytes) {
+#ifdef TCP_NOTSENT_LOWAT
+    int optval = static_cast<int>(bytes);
+    return ::setsockopt(sock_fd_, IPPROTO_TCP, TCP_NOTSENT_LOWAT, &optval,
+                        static_cast<socklen_t>(sizeof optval)) == 0;
+#else
+    (void)bytes;
+    return false;
+#endif
+}
+
+bool Socket::SetZeroCopy(bool on) {
+#ifdef SO_ZEROCOPY
+    int optval = on ? 1 : 0;
+    return ::setsockopt(sock_fd_, SOL_SOCKET, SO_ZEROCOPY, &optval,
+                        static_cast<socklen_t>(sizeof optval)) == 0;
+#else
+    return !on;
+#endif
+}
+
 void Socket::SetReuseAddr(bool on) {
     int optval = on ? 1 : 0;
     ::setsockopt(sock_fd_, SOL_SOCKET, SO_REUSEADDR, &optval,
@@ -74,6 +101,14 @@ void Socket::SetRecvBufSize(size_t size) {
     sockets::SetRecvBufSize(sock_fd_, size);
 }
 
+void Socket::SetRecvLowat(size_t bytes) {
+    int optval = static_cast<int>(bytes);
+    if (::setsockopt(sock_fd_, SOL_SOCKET, SO_RCVLOWAT, &optval,
+                     static_cast<socklen_t>(sizeof optval)) < 0) {
+        LOG_SYSERR << "Socket::SetRecvLowat";
+    }
+}
+
 namespace sockets {
 int CreateNonblockingOrDie(sa_family_t family) {
     int fd = ::socket(family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC,
@@ -150,6 +185,62 @@ ssize_t Write(int sockfd, const void *buf, size_t count) {
     return ::write(sockfd, buf, count);
 }
 
+ssize_t Writev(int sockfd, const struct iovec *iov, int iovcnt) {
+    return ::writev(sockfd, iov, iovcnt);
+}
+
+ssize_t SendFile(int sockfd, int in_fd, off_t *offset, size_t count) {
+    return ::sendfile(sockfd, in_fd, offset, count);
+}
+
+ssize_t SendZeroCopy(int sockfd, const void *buf, size_t count,
+                     bool *zerocopy) {
+#ifdef MSG_ZEROCOPY
+    ssize_t n = ::send(sockfd, buf, count, MSG_ZEROCOPY);
+    // out of optmem, pages are not pinned
+    if (n >= 0 || errno != ENOBUFS) {
+        *zerocopy = n >= 0;
+        return n;
+    }
+#endif
+    *zerocopy = false;
+    return ::send(sockfd, buf, count, 0);
+}
+
+bool ReadZeroCopyCompletion(int sockfd, uint32_t *lo, uint32_t *hi) {
+    char control[128];
+    for (;;) {
+        struct msghdr msg;
+        ::bzero(&msg, sizeof msg);
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof control;
+        if (::recvmsg(sockfd, &msg, MSG_ERRQUEUE) < 0) {
+            if (errno != EAGAIN) {
+                LOG_SYSERR << "sockets::ReadZeroCopyCompletion";
+            }
+            return false;
+        }
+        for (struct cmsghdr *cm = CMSG_FIRSTHDR(&msg); cm;
+             cm = CMSG_NXTHDR(&msg, cm)) {
+            if (!(cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_RECVERR) &&
+                !(cm->cmsg_level == SOL_IPV6 &&
+                  cm->cmsg_type == IPV6_RECVERR)) {
+                continue;
+            }
+            const struct sock_extended_err *err =
+                reinterpret_cast<const struct sock_extended_err *>(
+                    CMSG_DATA(cm));
+            // 其他错误跳过
+            if (err->ee_errno == 0 &&
+                err->ee_origin == SO_EE_ORIGIN_ZEROCOPY) {
+                *lo = err->ee_info;
+                *hi = err->ee_data;
+                return true;
+            }
+        }
+    }
+}
+
 ssize_t SendTo(int sockfd, const void *buf, size_t count,
                const struct sockaddr *addr) {
     socklen_t addrlen = static_cast<socklen_t>(sizeof(struct sockaddr_in6));
@@ -4,6 +4,7 @@
 #include "inet_address.h"
 
 #include <netinet/in.h>
+#include <sys/uio.h>
 
 namespace muduo {
 ///
@@ -49,6 +50,13 @@ public:
     ///
     void SetTcpNoDelay(bool on);
 
+    ///
+    /// Sets TCP_NOTSENT_LOWAT, the unsent bytes above which the socket
+    /// does not report writable.
+    /// @return false if the kernel does not support it
+    ///
+    bool SetTcpNotSentLowat(size_t bytes);
+
     ///
     /// Enable/disable SO_REUSEADDR
     ///
@@ -68,6 +76,18 @@ public:
 
     void SetRecvBufSize(size_t size);
 
+    ///
+    /// Sets SO_RCVLOWAT, the bytes queued before the socket reports
+    /// readable.
+    ///
+    void SetRecvLowat(size_t bytes);
+
+    ///
+    /// Enable/disable SO_ZEROCOPY, needed by MSG_ZEROCOPY sends.
+    /// @return false if the kernel does not support it
+    ///
+    bool SetZeroCopy(bool on);
+
 private:
     const int sock_fd_;
 };
@@ -89,6 +109,17 @@ int Accept(int sockfd, struct sockaddr_in6 *addr);
 // ssize_t readv(int sockfd, const struct iovec *iov, int iovcnt);
 
 ssize_t Write(int sockfd, const void *buf, size_t count);
+ssize_t Writev(int sockfd, const struct iovec *iov, int iovcnt);
+ssize_t SendFile(int sockfd, int in_fd, off_t *offset, size_t count);
+/// send(2) with MSG_ZEROCOPY, @c buf must stay unchanged until the kernel
+/// reports the send complete, see ReadZeroCopyCompletion(). Copies instead
+/// if the kernel is short of memory for it, *zerocopy tells which it did.
+ssize_t SendZeroCopy(int sockfd, const void *buf, size_t count,
+                     bool *zerocopy);
+/// Reads the error queue up to the next MSG_ZEROCOPY completion, which
+/// covers the sends [*lo, *hi] counted from 0 on the socket.
+/// @return false once the error queue is empty
+bool ReadZeroCopyCompletion(int sockfd, uint32_t *lo, uint32_t *hi);
 ssize_t SendTo(int sockfd, const void *buf, size_t count,
                const struct sockaddr *addr);
 
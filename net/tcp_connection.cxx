@@ -2,8 +2,17 @@
 #include "eventloop/channel.h"
 #include "logger/logger.h"
 
+#include <algorithm>
+#include <climits>
+#include <unistd.h>
+
 namespace muduo {
 namespace net {
+
+const size_t TcpConnection::kDefaultHighWaterMark;
+const size_t TcpConnection::kMinReceiveLowat;
+const size_t TcpConnection::kMaxReceiveLowat;
+
 TcpConnection::TcpConnection(event_loop::EventLoop *loop,
                              const std::string &name, int sockfd,
                              const InetAddress &local_addr,
@@ -14,7 +23,27 @@ TcpConnection::TcpConnection(event_loop::EventLoop *loop,
       peer_addr_(peer_addr),
       state_(kConnecting),
       socket_(new Socket(sockfd)),
-      channel_(new event_loop::Channel(loop, sockfd)) {
+      channel_(new event_loop::Channel(loop, sockfd)),
+      write_shut_down_(false),
+      receive_buffer_(loop->memory_pool()),
+      send_buffer_(loop->memory_pool()),
+      buffer_shrink_threshold_(0),
+      zero_buffer_idle_(false),
+      high_water_mark_(kDefaultHighWaterMark),
+      low_water_mark_(0),
+      above_high_water_mark_(false),
+      backpressure_count_(0),
+      read_pause_reasons_(0),
+      receive_buffer_cap_(0),
+      read_budget_(0),
+      bytes_needed_(0),
+      receive_lowat_(1),
+      zerocopy_threshold_(0),
+      zerocopy_next_id_(0),
+      notsent_lowat_(0),
+      write_complete_pending_(false),
+      auto_cork_(false),
+      cork_flush_queued_(false) {
     channel_->set_read_callback(
         std::bind(&TcpConnection::HandleRead, this, std::placeholders::_1));
     channel_->set_write_callback(std::bind(&TcpConnection::HandleWrite, this));
@@ -36,10 +65,8 @@ void TcpConnection::Send(const void *message, int len) {
             SendInLoop(message, len);
         } else {
             // 其他线程复制数据
-            void (TcpConnection::*fp)(const std::string &message) =
-                &TcpConnection::SendInLoop;
-            loop_->RunInLoop(
-                std::bind(fp, this, std::string((char *)message, len)));
+            QueueSend(PendingSend(BufferSlice(
+                std::string(static_cast<const char *>(message), len))));
         }
     }
 }
@@ -48,6 +75,82 @@ void TcpConnection::Send(const std::string &message) {
     Send(message.data(), message.length());
 }
 
+void TcpConnection::Send(std::string &&message) {
+    if (state_ == kConnected) {
+        if (loop_->IsInLoopThread() && !UseZeroCopy(message.length())) {
+            SendInLoop(message.data(), message.length());
+        } else if (loop_->IsInLoopThread()) {
+            SendInLoop(BufferSlice(std::move(message)));
+        } else {
+            QueueSend(PendingSend(BufferSlice(std::move(message))));
+        }
+    }
+}
+
+void TcpConnection::Send(Buffer &&buffer) {
+    if (state_ == kConnected) {
+        if (loop_->IsInLoopThread() && !UseZeroCopy(buffer.ReadableBytes())) {
+            SendInLoop(buffer.Peek(), buffer.ReadableBytes());
+            buffer.RetrieveAll();
+        } else if (loop_->IsInLoopThread()) {
+            SendInLoop(buffer.RetrieveAllAsSlice());
+        } else {
+            QueueSend(PendingSend(buffer.RetrieveAllAsSlice()));
+        }
+    }
+}
+
+void TcpConnection::Send(const BufferSlice &slice) {
+    if (state_ == kConnected) {
+        if (loop_->IsInLoopThread()) {
+            SendInLoop(slice);
+        } else {
+            // 只复制引用
+            QueueSend(PendingSend(slice));
+        }
+    }
+}
+
+void TcpConnection::Send(const struct iovec *fragments, int count) {
+    if (state_ == kConnected) {
+        if (loop_->IsInLoopThread()) {
+            SendInLoop(fragments, count);
+        } else {
+            std::string message;
+            for (int i = 0; i < count; ++i) {
+                message.append(static_cast<const char *>(fragments[i].iov_base),
+                               fragments[i].iov_len);
+            }
+            QueueSend(PendingSend(BufferSlice(std::move(message))));
+        }
+    }
+}
+
+void TcpConnection::Send(const StringPiece *fragments, int count) {
+    std::vector<struct iovec> vec(count);
+    for (int i = 0; i < count; ++i) {
+        vec[i].iov_base = const_cast<char *>(fragments[i].data());
+        vec[i].iov_len = fragments[i].size();
+    }
+    Send(vec.data(), count);
+}
+
+void TcpConnection::SendFile(int fd, off_t offset, size_t len) {
+    if (state_ == kConnected) {
+        // the range is sent later, it must not depend on the caller's fd
+        int file_fd = ::dup(fd);
+        if (file_fd < 0) {
+            LOG_SYSERR << "TcpConnection::SendFile";
+            return;
+        }
+        if (loop_->IsInLoopThread()) {
+            SendFileInLoop(file_fd, offset, len);
+        } else {
+            QueueSend(PendingSend(file_fd, offset, len));
+        }
+    }
+}
+
 void TcpConnection::Shutdown() {
     // FIXME: use compare and swap
     if (state_ == kConnected) {
@@ -59,77 +162,364 @@ void TcpConnection::Shutdown() {
 
 void TcpConnection::SetTcpNoDelay(bool on) { socket_->SetTcpNoDelay(on); }
 
+bool TcpConnection::SetTcpNotSentLowat(size_t bytes) {
+    loop_->AssertInLoopThread();
+    if (!socket_->SetTcpNotSentLowat(bytes)) {
+        LOG_SYSERR << "TcpConnection::SetTcpNotSentLowat";
+        return false;
+    }
+    notsent_lowat_ = bytes;
+    return true;
+}
+
+void TcpConnection::StartRead() {
+    loop_->RunInLoop(
+        std::bind(&TcpConnection::StartReadInLoop, shared_from_this()));
+}
+
+void TcpConnection::StopRead() {
+    loop_->RunInLoop(std::bind(&TcpConnection::PauseReading,
+                               shared_from_this(), kReadPausedByUser));
+}
+
+void TcpConnection::StartReadInLoop() {
+    int reasons = kReadPausedByUser;
+    if (receive_buffer_cap_ == 0 ||
+        receive_buffer_.ReadableBytes() < receive_buffer_cap_) {
+        reasons |= kReadPausedByReceiveCap;
+    }
+    ResumeReading(reasons);
+}
+
+void TcpConnection::set_zero_buffer_idle(bool on) {
+    zero_buffer_idle_ = on;
+    if (on) {
+        ReclaimBuffers();
+    }
+}
+
+bool TcpConnection::EnableReceiveRing(size_t size) {
+    loop_->AssertInLoopThread();
+    if (!receive_buffer_.EnableRing(size)) {
+        LOG_SYSERR << "TcpConnection::EnableReceiveRing";
+        return false;
+    }
+    return true;
+}
+
+void TcpConnection::ReclaimBuffers() {
+    if (receive_buffer_.ReadableBytes() == 0) {
+        if (zero_buffer_idle_) {
+            if (receive_buffer_.HasStorage()) {
+                receive_buffer_.Shrink(0);
+            }
+        } else if (buffer_shrink_threshold_ > 0 &&
+                   receive_buffer_.capacity() > buffer_shrink_threshold_) {
+            receive_buffer_.Shrink(Buffer::kInitialSize);
+        }
+    }
+    if (zero_buffer_idle_) {
+        send_buffer_.Shrink();
+    }
+}
+
 void TcpConnection::ShutdownInLoop() {
     LOG_DEBUG << "TcpConnection::ShutdownInLoop " << channel_->fd();
     loop_->AssertInLoopThread();
-    if (!channel_->IsWriting()) {
-        // we are not writing
+    // sends queued from other threads before Shutdown() may not have been
+    // flushed yet, QueueSend() posts the flush after unlocking
+    FlushPendingSends();
+    if (!write_shut_down_ && !channel_->IsWriting() &&
+        send_buffer_.ReadableBytes() == 0) {
+        // we are not writing, nor holding corked sends
         socket_->ShutdownWrite();
+        write_shut_down_ = true;
     }
 }
 
-void TcpConnection::SendInLoop(const std::string &message) {
-    SendInLoop(message.data(), message.length());
+void TcpConnection::SendInLoop(const void *data, size_t len) {
+    loop_->AssertInLoopThread();
+    if (Corking()) {
+        Cork(static_cast<const char *>(data), len);
+        return;
+    }
+    struct iovec vec;
+    vec.iov_base = const_cast<void *>(data);
+    vec.iov_len = len;
+    size_t nwrote = 0;
+    if (WriteDirectly(&vec, 1, len, &nwrote) && nwrote < len) {
+        send_buffer_.Append(static_cast<const char *>(data) + nwrote,
+                            len - nwrote);
+        if (!channel_->IsWriting()) {
+            channel_->EnableWriting();
+        }
+        CheckWaterMarks();
+    }
 }
 
-void TcpConnection::SendInLoop(const void *data, size_t len) {
+void TcpConnection::SendInLoop(const BufferSlice &slice) {
+    loop_->AssertInLoopThread();
+    if (Corking()) {
+        Cork(slice);
+        return;
+    }
+    struct iovec vec;
+    vec.iov_base = const_cast<char *>(slice.data());
+    vec.iov_len = slice.size();
+    size_t nwrote = 0;
+    if (WriteDirectly(&vec, 1, slice.size(), &nwrote,
+                      UseZeroCopy(slice.size()) ? &slice : nullptr) &&
+        nwrote < slice.size()) {
+        send_buffer_.Append(slice.Slice(nwrote));
+        if (!channel_->IsWriting()) {
+            channel_->EnableWriting();
+        }
+        CheckWaterMarks();
+    }
+}
+
+void TcpConnection::SendInLoop(const struct iovec *fragments, int count) {
+    loop_->AssertInLoopThread();
+    if (Corking()) {
+        for (int i = 0; i < count; ++i) {
+            Cork(static_cast<const char *>(fragments[i].iov_base),
+                 fragments[i].iov_len);
+        }
+        return;
+    }
+    size_t len = 0;
+    for (int i = 0; i < count; ++i) {
+        len += fragments[i].iov_len;
+    }
+    // fragments past IOV_MAX are queued
+    size_t nwrote = 0;
+    if (!WriteDirectly(fragments, std::min(count, IOV_MAX), len, &nwrote) ||
+        nwrote == len) {
+        return;
+    }
+    // only the unsent tail is copied
+    for (int i = 0; i < count; ++i) {
+        const char *data = static_cast<const char *>(fragments[i].iov_base);
+        size_t size = fragments[i].iov_len;
+        if (nwrote >= size) {
+            nwrote -= size;
+        } else {
+            send_buffer_.Append(data + nwrote, size - nwrote);
+            nwrote = 0;
+        }
+    }
+    if (!channel_->IsWriting()) {
+        channel_->EnableWriting();
+    }
+    CheckWaterMarks();
+}
+
+void TcpConnection::Cork(const char *data, size_t len) {
+    if (state_ == kDisconnected) {
+        LOG_WARN << "disconnected, give up writing";
+        return;
+    }
+    send_buffer_.Append(data, len);
+    QueueCorkFlush();
+}
+
+void TcpConnection::Cork(const BufferSlice &slice) {
+    if (state_ == kDisconnected) {
+        LOG_WARN << "disconnected, give up writing";
+        return;
+    }
+    send_buffer_.Append(slice);
+    QueueCorkFlush();
+}
+
+void TcpConnection::QueueCorkFlush() {
+    CheckWaterMarks();
+    // one flush per iteration, after all events are handled
+    if (!cork_flush_queued_) {
+        cork_flush_queued_ = true;
+        loop_->QueueInLoop(
+            std::bind(&TcpConnection::FlushCorkedSends, shared_from_this()));
+    }
+}
+
+void TcpConnection::FlushCorkedSends() {
+    loop_->AssertInLoopThread();
+    cork_flush_queued_ = false;
+    // if writing, the socket is full and HandleWrite() sends them
+    if (state_ == kDisconnected || channel_->IsWriting() ||
+        send_buffer_.ReadableBytes() == 0) {
+        return;
+    }
+    WriteSendBuffer();
+    if (send_buffer_.ReadableBytes() > 0) {
+        channel_->EnableWriting();
+    }
+}
+
+void TcpConnection::SendFileInLoop(int fd, off_t offset, size_t len) {
     loop_->AssertInLoopThread();
-    ssize_t nwrote = 0;
-    size_t remaining = len;
-    bool faultError = false;
     if (state_ == kDisconnected) {
         LOG_WARN << "disconnected, give up writing";
+        ::close(fd);
         return;
     }
+    // sent from HandleWrite, after anything queued before it
+    send_buffer_.AppendFile(fd, offset, len);
+    if (send_buffer_.ReadableBytes() > 0 && !channel_->IsWriting()) {
+        channel_->EnableWriting();
+    }
+}
+
+void TcpConnection::QueueSend(PendingSend &&send) {
+    bool flush_queued;
+    {
+        std::lock_guard<std::mutex> lock(pending_sends_mutex_);
+        flush_queued = !pending_sends_.empty();
+        pending_sends_.push_back(std::move(send));
+    }
+    // one flush for all sends queued until it runs
+    if (!flush_queued) {
+        loop_->QueueInLoop(
+            std::bind(&TcpConnection::FlushPendingSends, shared_from_this()));
+    }
+}
+
+void TcpConnection::FlushPendingSends() {
+    loop_->AssertInLoopThread();
+    std::vector<PendingSend> sends;
+    {
+        std::lock_guard<std::mutex> lock(pending_sends_mutex_);
+        sends.swap(pending_sends_);
+    }
+
+    size_t i = 0;
+    while (i < sends.size()) {
+        if (sends[i].file_fd >= 0) {
+            SendFileInLoop(sends[i].file_fd, sends[i].file_offset,
+                           sends[i].file_len);
+            ++i;
+            continue;
+        }
+        if (UseZeroCopy(sends[i].slice.size())) {
+            SendInLoop(sends[i].slice);
+            ++i;
+            continue;
+        }
+        // the other slices in a row go in one writev(2)
+        size_t j = i;
+        while (j < sends.size() && sends[j].file_fd < 0 &&
+               !UseZeroCopy(sends[j].slice.size())) {
+            ++j;
+        }
+        SendSlicesInLoop(&sends[i], j - i);
+        i = j;
+    }
+}
+
+void TcpConnection::SendSlicesInLoop(const PendingSend *sends, size_t count) {
+    static const size_t kMaxIovecs = IOV_MAX;
+    struct iovec vec[kMaxIovecs];
+    size_t iovcnt = std::min(count, kMaxIovecs);
+    size_t len = 0;
+    for (size_t i = 0; i < iovcnt; ++i) {
+        vec[i].iov_base = const_cast<char *>(sends[i].slice.data());
+        vec[i].iov_len = sends[i].slice.size();
+        len += sends[i].slice.size();
+    }
+    size_t nwrote = 0;
+    if (!WriteDirectly(vec, static_cast<int>(iovcnt), len, &nwrote)) {
+        return;
+    }
+
+    // the rest is queued by reference
+    bool queued = false;
+    for (size_t i = 0; i < count; ++i) {
+        const BufferSlice &slice = sends[i].slice;
+        if (nwrote >= slice.size()) {
+            nwrote -= slice.size();
+        } else {
+            send_buffer_.Append(slice.Slice(nwrote));
+            nwrote = 0;
+            queued = true;
+        }
+    }
+    if (queued) {
+        if (!channel_->IsWriting()) {
+            channel_->EnableWriting();
+        }
+        CheckWaterMarks();
+    }
+}
+
+bool TcpConnection::WriteDirectly(const struct iovec *vec, int iovcnt,
+                                  size_t len, size_t *nwrote,
+                                  const BufferSlice *zerocopy) {
+    *nwrote = 0;
+    if (state_ == kDisconnected) {
+        LOG_WARN << "disconnected, give up writing";
+        return false;
+    }
     // if no thing in output queue, try writing directly
     if (!channel_->IsWriting() && send_buffer_.ReadableBytes() == 0) {
-        nwrote = sockets::Write(channel_->fd(), data, len);
-        if (nwrote >= 0) {
-            remaining = len - nwrote;
-            if (remaining == 0 && write_complete_callback_) {
-                loop_->QueueInLoop(
-                    std::bind(write_complete_callback_, shared_from_this()));
+        ssize_t n;
+        if (zerocopy) {
+            assert(iovcnt == 1);
+            bool pinned = false;
+            n = sockets::SendZeroCopy(channel_->fd(), vec[0].iov_base,
+                                      vec[0].iov_len, &pinned);
+            if (pinned) {
+                PinZeroCopy(*zerocopy);
+            }
+        } else if (iovcnt == 1) {
+            n = sockets::Write(channel_->fd(), vec[0].iov_base,
+                               vec[0].iov_len);
+        } else {
+            n = sockets::Writev(channel_->fd(), vec, iovcnt);
+        }
+        if (n >= 0) {
+            *nwrote = n;
+            if (*nwrote == len) {
+                QueueWriteComplete();
             }
-        } else // nwrote < 0
+        } else // n < 0
         {
-            nwrote = 0;
             if (errno != EWOULDBLOCK) {
                 LOG_SYSERR << "TcpConnection::SendInLoop";
                 if (errno == EPIPE || errno == ECONNRESET) // FIXME: any others?
                 {
-                    faultError = true;
+                    return false;
                 }
             }
         }
     }
-
-    assert(remaining <= len);
-    if (!faultError && remaining > 0) {
-        size_t oldLen = send_buffer_.ReadableBytes();
-        // TODO:
-        // if (oldLen + remaining >= highWaterMark_ && oldLen < highWaterMark_
-        // &&
-        //     highWaterMarkCallback_) {
-        //     loop_->queueInLoop(std::bind(highWaterMarkCallback_,
-        //                                  shared_from_this(),
-        //                                  oldLen + remaining));
-        // }
-        send_buffer_.Append(static_cast<const char *>(data) + nwrote,
-                            remaining);
-        if (!channel_->IsWriting()) {
-            channel_->EnableWriting();
-        }
-    }
+    assert(*nwrote <= len);
+    return true;
 }
 
 void TcpConnection::HandleRead(event_loop::Timestamp poll_time) {
     loop_->AssertInLoopThread();
     int saved_errno = 0;
-    ssize_t n = receive_buffer_.ReadFd(channel_->fd(), &saved_errno);
+    size_t max_bytes =
+        read_budget_ > 0 ? read_budget_ : static_cast<size_t>(-1);
+    // stops at the receive buffer cap
+    const size_t buffered = receive_buffer_.ReadableBytes();
+    if (receive_buffer_cap_ > buffered) {
+        max_bytes = std::min(max_bytes, receive_buffer_cap_ - buffered);
+    }
+    ssize_t n = receive_buffer_.ReadFd(
+        channel_->fd(), &saved_errno, loop_->read_scratch(),
+        event_loop::EventLoop::kReadScratchSize, max_bytes);
     LOG_TRACE << "TcpConnection::HandleRead length " << n;
     if (n > 0) {
+        bytes_needed_ = 0;
         if (message_callback_)
             message_callback_(shared_from_this(), &receive_buffer_, poll_time);
+        ReclaimBuffers();
+        UpdateReceiveLowat();
+        if (receive_buffer_cap_ > 0 &&
+            receive_buffer_.ReadableBytes() >= receive_buffer_cap_) {
+            PauseReading(kReadPausedByReceiveCap);
+        }
     } else if (n == 0) {
         HandleClose();
     } else {
@@ -139,40 +529,89 @@ void TcpConnection::HandleRead(event_loop::Timestamp poll_time) {
     }
 }
 
+void TcpConnection::UpdateReceiveLowat() {
+    size_t lowat = 1;
+    if (bytes_needed_ >= kMinReceiveLowat) {
+        // a high mark could stall on a small receive window
+        lowat = std::min(bytes_needed_, kMaxReceiveLowat);
+    }
+    if (lowat != receive_lowat_) {
+        socket_->SetRecvLowat(lowat);
+        receive_lowat_ = lowat;
+    }
+}
+
 void TcpConnection::HandleWrite() {
     LOG_TRACE << "TcpConnection::HandleWrite " << channel_->fd();
 
     loop_->AssertInLoopThread();
     if (channel_->IsWriting()) {
-        ssize_t n = sockets::Write(channel_->fd(), send_buffer_.Peek(),
-                                   send_buffer_.ReadableBytes());
-        if (n > 0) {
-            send_buffer_.Retrieve(n); // 改变可读数据索引
-            if (send_buffer_.ReadableBytes() == 0) {
-                // 没有数据就停止监控可写事件，避免不停回调
-                channel_->DisableWriting();
-                if (write_complete_callback_) {
-                    loop_->QueueInLoop(std::bind(write_complete_callback_,
-                                                 shared_from_this()));
-                }
-                // 正在主动关闭连接
-                if (state_ == kDisconnecting) {
-                    ShutdownInLoop();
-                }
+        if (write_complete_pending_ && send_buffer_.ReadableBytes() == 0) {
+            // the kernel has sent down to TCP_NOTSENT_LOWAT
+            write_complete_pending_ = false;
+            channel_->DisableWriting();
+            loop_->QueueInLoop(
+                std::bind(write_complete_callback_, shared_from_this()));
+            if (state_ == kDisconnecting) {
+                ShutdownInLoop();
             }
-        } else {
-            LOG_SYSERR << "TcpConnection::HandleWrite";
-            // if (state_ == kDisconnecting)
-            // {
-            //   shutdownInLoop();
-            // }
+            return;
         }
+        WriteSendBuffer();
     } else {
         LOG_TRACE << "Connection fd = " << channel_->fd()
                   << " is down, no more writing";
     }
 }
 
+void TcpConnection::WriteSendBuffer() {
+    int saved_errno = 0;
+    // gathers the queued slabs, drained ones are retrieved and freed
+    BufferSlice zerocopy_slice;
+    ssize_t n = send_buffer_.WriteFd(channel_->fd(), &saved_errno,
+                                     zerocopy_threshold_, &zerocopy_slice);
+    if (!zerocopy_slice.empty()) {
+        PinZeroCopy(zerocopy_slice);
+    }
+    // EWOULDBLOCK just means nothing was written, e.g. when flushing corked
+    // sends into a full socket
+    if (n < 0 && saved_errno != EWOULDBLOCK && saved_errno != EINTR) {
+        errno = saved_errno;
+        LOG_SYSERR << "TcpConnection::WriteSendBuffer";
+    }
+    CheckWaterMarks();
+    // a file range that cannot be sent is dropped with an error
+    if (send_buffer_.ReadableBytes() == 0) {
+        ReclaimBuffers();
+        if (n > 0) {
+            QueueWriteComplete();
+        }
+        // 没有数据就停止监控可写事件，避免不停回调
+        if (channel_->IsWriting() && !write_complete_pending_) {
+            channel_->DisableWriting();
+        }
+        // 正在主动关闭连接
+        if (state_ == kDisconnecting) {
+            ShutdownInLoop();
+        }
+    }
+}
+
+void TcpConnection::QueueWriteComplete() {
+    if (!write_complete_callback_) {
+        return;
+    }
+    if (notsent_lowat_ > 0) {
+        write_complete_pending_ = true;
+        if (!channel_->IsWriting()) {
+            channel_->EnableWriting();
+        }
+    } else {
+        loop_->QueueInLoop(
+            std::bind(write_complete_callback_, shared_from_this()));
+    }
+}
+
 void TcpConnection::HandleClose() {
     LOG_DEBUG << "TcpConnection::HandleClose " << channel_->fd();
 
@@ -183,6 +622,8 @@ void TcpConnection::HandleClose() {
     // we don't close fd, leave it to dtor, so we can find leaks easily.
     SetState(kDisconnected);
     channel_->DisableAll();
+    ReleaseBackpressure();
+    backpressure_upstream_.reset();
 
     TcpConnectionPtr guardThis(shared_from_this());
     connection_callback_(guardThis);
@@ -191,7 +632,13 @@ void TcpConnection::HandleClose() {
 }
 
 void TcpConnection::HandleError() {
+    // MSG_ZEROCOPY completions come as errors too
+    size_t completions =
+        zerocopy_pinned_.empty() ? 0 : ReapZeroCopyCompletions();
     int err = sockets::GetSocketErrno(channel_->fd());
+    if (err == 0 && completions > 0) {
+        return;
+    }
     LOG_ERROR << "TcpConnection::HandleError [" << name_
               << "] - SO_ERROR = " << err << " " << strerror_tl(err);
 }
@@ -205,7 +652,9 @@ void TcpConnection::ConnectEstablished() {
         before_reading_callback_(shared_from_this());
 
     channel_->Tie(shared_from_this());
-    channel_->EnableReading();
+    if (read_pause_reasons_ == 0) {
+        channel_->EnableReading();
+    }
 
     connection_callback_(shared_from_this());
 }
@@ -217,11 +666,134 @@ void TcpConnection::ConnectDestroyed() {
     if (state_ == kConnected) {
         SetState(kDisconnected);
         channel_->DisableAll();
+        ReleaseBackpressure();
+        backpressure_upstream_.reset();
 
         connection_callback_(shared_from_this());
     }
     channel_->RemoveFromLoop();
 }
 
+void TcpConnection::set_backpressure_upstream(
+    const TcpConnectionPtr &upstream) {
+    loop_->AssertInLoopThread();
+    ReleaseBackpressure();
+    backpressure_upstream_ = upstream;
+    if (upstream && above_high_water_mark_) {
+        upstream->ApplyBackpressure(true);
+    }
+}
+
+bool TcpConnection::EnableZeroCopy(size_t threshold) {
+    loop_->AssertInLoopThread();
+    if (threshold > 0 && !socket_->SetZeroCopy(true)) {
+        LOG_SYSERR << "TcpConnection::EnableZeroCopy";
+        return false;
+    }
+    zerocopy_threshold_ = threshold;
+    return true;
+}
+
+void TcpConnection::PinZeroCopy(const BufferSlice &slice) {
+    zerocopy_pinned_.push_back(slice);
+    ++zerocopy_next_id_;
+}
+
+size_t TcpConnection::ReapZeroCopyCompletions() {
+    size_t completions = 0;
+    uint32_t lo, hi;
+    while (sockets::ReadZeroCopyCompletion(channel_->fd(), &lo, &hi)) {
+        ++completions;
+        // ids wrap around, so does the arithmetic
+        uint32_t first = zerocopy_next_id_ -
+                         static_cast<uint32_t>(zerocopy_pinned_.size());
+        for (uint32_t id = lo;; ++id) {
+            uint32_t index = id - first;
+            if (index < zerocopy_pinned_.size()) {
+                zerocopy_pinned_[index] = BufferSlice();
+            }
+            if (id == hi) {
+                break;
+            }
+        }
+        // completions may come out of order
+        while (!zerocopy_pinned_.empty() && zerocopy_pinned_.front().empty()) {
+            zerocopy_pinned_.pop_front();
+        }
+    }
+    return completions;
+}
+
+void TcpConnection::PauseReading(int reason) {
+    loop_->AssertInLoopThread();
+    read_pause_reasons_ |= reason;
+    if (state_ != kConnecting && channel_->IsReading()) {
+        channel_->DisableReading();
+    }
+}
+
+void TcpConnection::ResumeReading(int reason) {
+    loop_->AssertInLoopThread();
+    read_pause_reasons_ &= ~reason;
+    if (read_pause_reasons_ == 0 &&
+        (state_ == kConnected || state_ == kDisconnecting) &&
+        !channel_->IsReading()) {
+        channel_->EnableReading();
+    }
+}
+
+void TcpConnection::CheckWaterMarks() {
+    // file ranges are not held in memory
+    size_t queued = send_buffer_.ReadableBytes() - send_buffer_.FileBytes();
+    if (!above_high_water_mark_ && queued >= high_water_mark_) {
+        above_high_water_mark_ = true;
+        if (high_water_mark_callback_) {
+            loop_->QueueInLoop(std::bind(high_water_mark_callback_,
+                                         shared_from_this(), queued));
+        }
+        if (TcpConnectionPtr upstream = backpressure_upstream_.lock()) {
+            upstream->ApplyBackpressure(true);
+        }
+    } else if (above_high_water_mark_ && queued <= low_water_mark_) {
+        above_high_water_mark_ = false;
+        if (low_water_mark_callback_) {
+            loop_->QueueInLoop(std::bind(low_water_mark_callback_,
+                                         shared_from_this(), queued));
+        }
+        if (TcpConnectionPtr upstream = backpressure_upstream_.lock()) {
+            upstream->ApplyBackpressure(false);
+        }
+    }
+}
+
+void TcpConnection::ApplyBackpressure(bool on) {
+    loop_->RunInLoop(std::bind(&TcpConnection::ApplyBackpressureInLoop,
+                               shared_from_this(), on));
+}
+
+void TcpConnection::ApplyBackpressureInLoop(bool on) {
+    loop_->AssertInLoopThread();
+    // several downstream connections may hold one upstream back
+    if (on) {
+        if (backpressure_count_++ == 0) {
+            PauseReading(kReadPausedByBackpressure);
+        }
+    } else {
+        assert(backpressure_count_ > 0);
+        if (--backpressure_count_ == 0) {
+            ResumeReading(kReadPausedByBackpressure);
+        }
+    }
+}
+
+void TcpConnection::ReleaseBackpressure() {
+    if (!above_high_water_mark_) {
+        return;
+    }
+    if (TcpConnectionPtr upstream = backpressure_upstream_.lock()) {
+        upstream->ApplyBackpressure(false);
+    }
+}
+
 } // namespace net
 } // namespace muduo
\ No newline at end of file
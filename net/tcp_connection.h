@@ -2,12 +2,16 @@
 #define __MUDUO_NET_TCP_CONNECTION_H_
 
 #include "buffer.h"
+#include "buffer_chain.h"
 #include "callback.h"
 #include "eventloop/eventloop.h"
 #include "inet_address.h"
 #include "inet_socket.h"
 
+#include <deque>
 #include <memory>
+#include <mutex>
+#include <vector>
 
 namespace muduo {
 namespace net {
@@ -25,8 +29,29 @@ public:
     const InetAddress &local_addr() const { return local_addr_; }
     const InetAddress &peer_addr() const { return peer_addr_; }
 
+    ///
+    /// Thread safe. From other threads, sends are queued on the connection
+    /// and the loop writes all queued so far with one writev(2). The rvalue
+    /// and slice overloads pass their bytes on without copying them.
+    ///
     void Send(const void *data, int len);
     void Send(const std::string &message);
+    void Send(std::string &&message);
+    /// Sends the readable bytes of @c buffer, taking its storage over.
+    void Send(Buffer &&buffer);
+    void Send(const BufferSlice &slice);
+    /// Sends the fragments in order, as one message, e.g. a prebuilt
+    /// header and a body owned elsewhere. They are gathered with writev(2)
+    /// and only the unsent tail is copied. From other threads, they are
+    /// copied once, into one slice.
+    void Send(const struct iovec *fragments, int count);
+    void Send(const StringPiece *fragments, int count);
+
+    /// Sends @c len bytes of file @c fd from @c offset with sendfile(2),
+    /// in order with the other sends. @c fd is duplicated, the caller may
+    /// close it right away. The write complete callback is called only once
+    /// the whole range is sent. Thread safe.
+    void SendFile(int fd, off_t offset, size_t len);
 
     void Shutdown(); // NOT thread safe, no simultaneous calling
 
@@ -35,6 +60,83 @@ public:
 
     void SetTcpNoDelay(bool on);
 
+    /// Sets TCP_NOTSENT_LOWAT, so the kernel holds no more than @c bytes
+    /// not sent yet. The write complete callback then waits for EPOLLOUT,
+    /// reported once the unsent bytes fall below @c bytes, so a streaming
+    /// producer makes data just in time instead of filling the kernel.
+    /// Call in the loop thread.
+    /// @return false if the kernel does not support it
+    bool SetTcpNotSentLowat(size_t bytes);
+
+    ///
+    /// Flow control on the receiving side. While reading is stopped, the
+    /// socket buffer fills up and TCP pushes back on the peer. Thread safe.
+    ///
+    /// StartRead() also resumes reading paused by the receive buffer cap,
+    /// if the receive buffer has been consumed below it.
+    ///
+    void StartRead();
+    void StopRead();
+    /// NOT thread safe, may race with StartRead() and StopRead().
+    bool IsReading() const { return read_pause_reasons_ == 0; }
+
+    /// For codecs of large frames: called from the message callback, when
+    /// the receive buffer holds part of a frame, with the bytes still
+    /// missing. The connection sets SO_RCVLOWAT, capped at
+    /// kMaxReceiveLowat, so the loop wakes up once they have arrived rather
+    /// than for every chunk. It is reset after the next read. Fewer than
+    /// kMinReceiveLowat bytes are ignored.
+    void NeedMoreBytes(size_t bytes) { bytes_needed_ = bytes; }
+
+    static const size_t kMinReceiveLowat = 64 * 1024;
+    static const size_t kMaxReceiveLowat = 1024 * 1024;
+
+    /// Stops reading once the message callback leaves @c bytes or more in
+    /// the receive buffer, until StartRead() finds it consumed below that.
+    /// Reads never take the buffer past @c bytes. 0, the default, never
+    /// stops. Call in the loop thread.
+    void set_receive_buffer_cap(size_t bytes) { receive_buffer_cap_ = bytes; }
+
+    /// Reads at most @c bytes per readable event, so a fast sender cannot
+    /// hog the loop. What is left stays in the socket and, epoll being
+    /// level triggered, is reported again by the next poll, behind the
+    /// other ready connections. 0, the default, reads what fits in the
+    /// buffer and the loop's read scratch. Call in the loop thread.
+    void set_read_budget(size_t bytes) { read_budget_ = bytes; }
+
+    /// Once the message callback leaves the receive buffer drained, shrinks
+    /// it back to Buffer::kInitialSize if it has grown beyond @c bytes.
+    /// 0, the default, never shrinks. Call in the loop thread.
+    void set_buffer_shrink_threshold(size_t bytes) {
+        buffer_shrink_threshold_ = bytes;
+    }
+
+    /// Holds no buffer memory while idle. Drained buffers are freed back to
+    /// the loop's pool. The next read lands in the loop's read scratch and
+    /// is then copied into a block taken from the pool, which the message
+    /// callback sees as usual, so every read after idle pays one extra copy.
+    /// Call in the loop thread.
+    void set_zero_buffer_idle(bool on);
+
+    /// Receives into a fixed ring of @c size bytes, which never compacts,
+    /// see Buffer::EnableRing(). A message outgrowing the ring moves the
+    /// receive buffer back to linear storage. Call in the loop thread.
+    bool EnableReceiveRing(size_t size);
+
+    /// Sends slices of at least @c threshold bytes with MSG_ZEROCOPY, see
+    /// Send(const BufferSlice &). Their storage is kept until the kernel
+    /// reports the send complete on the error queue, or until the
+    /// connection is destroyed. 0 turns it off. Call in the loop thread.
+    /// @return false if the kernel does not support SO_ZEROCOPY
+    bool EnableZeroCopy(size_t threshold);
+
+    /// Auto-cork: sends made while the loop handles events, e.g. from the
+    /// message callback, are only queued. They are written together, with
+    /// one writev(2), once the loop has handled all events of the
+    /// iteration. Saves syscalls and small packets for handlers sending a
+    /// message in pieces. Call in the loop thread.
+    void set_auto_cork(bool on) { auto_cork_ = on; }
+
     // 连接已经建立，但是还没开始读取数据（可以用来设置message callback等）
     void set_before_reading_callback(const BeforeReadingCallback &cb) {
         before_reading_callback_ = cb;
@@ -55,6 +157,28 @@ public:
         write_complete_callback_ = cb;
     }
 
+    /// Called once the send buffer grows to @c high_water_mark bytes, and
+    /// again only after it has fallen to the low water mark since.
+    void set_high_water_mark_callback(const HighWaterMarkCallback &cb,
+                                      size_t high_water_mark) {
+        high_water_mark_callback_ = cb;
+        high_water_mark_ = high_water_mark;
+    }
+
+    /// Called once the send buffer has fallen from the high water mark to
+    /// @c low_water_mark bytes. 0, the default, waits until it drains.
+    void set_low_water_mark_callback(const LowWaterMarkCallback &cb,
+                                     size_t low_water_mark) {
+        low_water_mark_callback_ = cb;
+        low_water_mark_ = low_water_mark;
+    }
+
+    /// Stops reading from @c upstream while the send buffer of this
+    /// connection is above the high water mark, and resumes at the low one,
+    /// e.g. for a proxy relaying @c upstream here. @c upstream may live in
+    /// another loop. Pass nullptr to detach. Call in the loop thread.
+    void set_backpressure_upstream(const TcpConnectionPtr &upstream);
+
     /// Internal use only.
     void set_close_callback(const CloseCallback &cb) { close_callback_ = cb; }
 
@@ -71,14 +195,88 @@ private:
         kDisconnecting
     };
 
+    // why reading is paused, a bitmask
+    enum ReadPauseReason {
+        kReadPausedByBackpressure = 1 << 0,
+        kReadPausedByUser = 1 << 1,
+        kReadPausedByReceiveCap = 1 << 2,
+    };
+
+    static const size_t kDefaultHighWaterMark = 64 * 1024 * 1024;
+
     void SetState(ConnectionState s) { state_ = s; }
 
     void ShutdownInLoop();
-    void SendInLoop(const std::string &message);
     void SendInLoop(const void *message, size_t len);
+    void SendInLoop(const BufferSlice &slice);
+    void SendInLoop(const struct iovec *fragments, int count);
+    // takes the fd over
+    void SendFileInLoop(int fd, off_t offset, size_t len);
+
+    bool Corking() const { return auto_cork_ && loop_->event_handling(); }
+    // queues @c data for the flush at the end of the loop iteration
+    void Cork(const char *data, size_t len);
+    void Cork(const BufferSlice &slice);
+    void QueueCorkFlush();
+    void FlushCorkedSends();
+
+    // a send from another thread, a slice or a file range
+    struct PendingSend {
+        explicit PendingSend(BufferSlice s)
+            : slice(std::move(s)),
+              file_fd(-1),
+              file_offset(0),
+              file_len(0) {}
+        PendingSend(int fd, off_t offset, size_t len)
+            : file_fd(fd), file_offset(offset), file_len(len) {}
+
+        BufferSlice slice;
+        int file_fd;
+        off_t file_offset;
+        size_t file_len;
+    };
+
+    // queues a send from another thread, see FlushPendingSends()
+    void QueueSend(PendingSend &&send);
+    void FlushPendingSends();
+    void SendSlicesInLoop(const PendingSend *sends, size_t count);
+    // writes what the socket takes if nothing is queued yet,
+    // @return false if the rest must not be queued either
+    // with @c zerocopy, sends its single iovec with MSG_ZEROCOPY
+    bool WriteDirectly(const struct iovec *vec, int iovcnt, size_t len,
+                       size_t *nwrote, const BufferSlice *zerocopy = nullptr);
+
+    bool UseZeroCopy(size_t len) const {
+        return zerocopy_threshold_ > 0 && len >= zerocopy_threshold_;
+    }
+    // keeps @c slice until its MSG_ZEROCOPY send completes
+    void PinZeroCopy(const BufferSlice &slice);
+    // @return number of completions read from the error queue
+    size_t ReapZeroCopyCompletions();
+
+    // applies the shrink policy to drained buffers
+    void ReclaimBuffers();
+
+    // reading stays off while any reason is set
+    void PauseReading(int reason);
+    void ResumeReading(int reason);
+    void StartReadInLoop();
+    // applies what the codec asked with NeedMoreBytes()
+    void UpdateReceiveLowat();
+    // fires the water mark callbacks when the send buffer crosses a mark
+    void CheckWaterMarks();
+    // thread safe, counts downstream connections holding this one back
+    void ApplyBackpressure(bool on);
+    void ApplyBackpressureInLoop(bool on);
+    // lets the upstream go if this connection holds it back
+    void ReleaseBackpressure();
 
     void HandleRead(event_loop::Timestamp poll_time);
     void HandleWrite();
+    // writes the send buffer, stops writing once it drains
+    void WriteSendBuffer();
+    // called once the send buffer is written out
+    void QueueWriteComplete();
     void HandleClose();
     void HandleError();
 
@@ -92,15 +290,52 @@ private:
 
     std::unique_ptr<Socket> socket_;
     std::unique_ptr<event_loop::Channel> channel_;
+    // the write side is shut down once, by whichever of Shutdown() and the
+    // drained send buffer comes last
+    bool write_shut_down_;
 
     BeforeReadingCallback before_reading_callback_;
     ConnectionCallback connection_callback_;
     MessageCallback message_callback_;
     WriteCompleteCallback write_complete_callback_;
+    HighWaterMarkCallback high_water_mark_callback_;
+    LowWaterMarkCallback low_water_mark_callback_;
     CloseCallback close_callback_;
 
     Buffer receive_buffer_;
-    Buffer send_buffer_; // FIXME: use list<Buffer> as output buffer.
+    BufferChain send_buffer_;
+    // sends from other threads, not flushed yet
+    std::mutex pending_sends_mutex_;
+    std::vector<PendingSend> pending_sends_;
+
+    size_t buffer_shrink_threshold_;
+    bool zero_buffer_idle_;
+
+    size_t high_water_mark_;
+    size_t low_water_mark_;
+    bool above_high_water_mark_;
+    std::weak_ptr<TcpConnection> backpressure_upstream_;
+    int backpressure_count_;
+    int read_pause_reasons_;
+    size_t receive_buffer_cap_;
+    size_t read_budget_;
+    // set by NeedMoreBytes() within the message callback
+    size_t bytes_needed_;
+    // SO_RCVLOWAT of the socket
+    size_t receive_lowat_;
+
+    size_t zerocopy_threshold_;
+    // slices of the MSG_ZEROCOPY sends not completed yet, the last one
+    // numbered zerocopy_next_id_ - 1, completed ones are left empty
+    std::deque<BufferSlice> zerocopy_pinned_;
+    uint32_t zerocopy_next_id_;
+
+    // with TCP_NOTSENT_LOWAT, write complete waits for EPOLLOUT
+    size_t notsent_lowat_;
+    bool write_complete_pending_;
+
+    bool auto_cork_;
+    bool cork_flush_queued_;
 };
 
 } // namespace net
@@ -16,7 +16,8 @@ UdpServer::UdpServer(event_loop::EventLoop *loop, const std::string &name,
       local_addr_(local_addr),
       state_(kUnbinded),
       socket_(new Socket(sockfd)),
-      channel_(new event_loop::Channel(loop, sockfd)) {
+      channel_(new event_loop::Channel(loop, sockfd)),
+      receive_buffer_(loop->memory_pool()) {
     channel_->set_read_callback(
         std::bind(&UdpServer::HandleRead, this, std::placeholders::_1));
     // TODO： UDP无法触发close回调